@@ -0,0 +1,220 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Allocator for the dense storages. Small buffers are aligned to cache lines. Large
+// buffers are mapped directly from the OS on huge-page boundaries, optionally backed by
+// transparent huge pages or by the reserved MAP_HUGETLB pool, which reduces TLB misses
+// for random-access fills into big histograms. Large buffers can also be touched first
+// by several threads, so that on NUMA systems their pages are spread over the nodes of
+// the threads that fill them.
+//
+// The policy is process-wide and only affects new allocations. Whether a buffer was
+// mapped is decided by its size alone, so changing the policy while histograms are
+// alive is safe.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+enum class huge_pages {
+    none,        ///< regular pages
+    transparent, ///< advise the kernel to use transparent huge pages
+    hugetlb      ///< use the reserved huge page pool, fall back to regular pages
+};
+
+struct allocation_policy {
+    std::atomic<huge_pages> pages{huge_pages::none};
+    /// Number of threads that touch large buffers first, 0 or 1 disables this
+    std::atomic<unsigned> first_touch_threads{0};
+};
+
+inline allocation_policy& global_allocation_policy() {
+    static allocation_policy policy;
+    return policy;
+}
+
+namespace detail {
+
+constexpr std::size_t cache_line_size = 64;
+constexpr std::size_t huge_page_size  = std::size_t{1} << 21;
+
+inline std::size_t round_up(std::size_t n, std::size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+/// Write zeros into contiguous chunks of the buffer from several threads. If a thread
+/// cannot be started, the calling thread zeros the chunks that are left.
+inline void first_touch(void* ptr, std::size_t bytes, unsigned threads) noexcept {
+    if(threads < 2)
+        return;
+    char* const start = static_cast<char*>(ptr);
+    const auto chunk  = round_up((bytes + threads - 1) / threads, 4096);
+    const auto zero   = [=](std::size_t begin) {
+        std::memset(start + begin, 0, (std::min)(chunk, bytes - begin));
+    };
+    std::vector<std::thread> pool;
+    std::size_t begin = 0;
+    try {
+        pool.reserve(threads);
+        for(; begin < bytes; begin += chunk)
+            pool.emplace_back(zero, begin);
+    } catch(...) {
+        // the threads that did start are joined below, destroying them would terminate
+    }
+    for(; begin < bytes; begin += chunk)
+        zero(begin);
+    for(auto& thread : pool)
+        thread.join();
+}
+
+inline void* allocate_cache_aligned(std::size_t bytes) {
+    bytes = (std::max)(bytes, cache_line_size);
+#ifdef _WIN32
+    void* ptr = ::_aligned_malloc(bytes, cache_line_size);
+#else
+    void* ptr = nullptr;
+    if(::posix_memalign(&ptr, cache_line_size, bytes) != 0)
+        ptr = nullptr;
+#endif
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+inline void deallocate_cache_aligned(void* ptr) noexcept {
+#ifdef _WIN32
+    ::_aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+#ifdef _WIN32
+inline void* allocate_huge(std::size_t bytes) {
+    void* ptr          = allocate_cache_aligned(bytes);
+    const auto threads = global_allocation_policy().first_touch_threads.load();
+    // large buffers are handed out zeroed, see aligned_allocator::allocates_zeros
+    if(threads < 2)
+        std::memset(ptr, 0, bytes);
+    else
+        first_touch(ptr, bytes, threads);
+    return ptr;
+}
+
+inline void deallocate_huge(void* ptr, std::size_t) noexcept {
+    deallocate_cache_aligned(ptr);
+}
+#else
+inline void* allocate_huge(std::size_t bytes) {
+    const auto& policy = global_allocation_policy();
+    const auto pages   = policy.pages.load();
+    const auto size    = round_up(bytes, huge_page_size);
+    void* ptr          = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if(pages == huge_pages::hugetlb)
+        ptr = ::mmap(nullptr,
+                     size,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                     -1,
+                     0);
+#endif
+
+    if(ptr == MAP_FAILED) {
+        // map one extra huge page and trim, so the buffer starts on a huge page
+        const auto mapped = size + huge_page_size;
+        const int flags   = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* raw = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if(raw == MAP_FAILED)
+            throw std::bad_alloc();
+        char* const first = static_cast<char*>(raw);
+        char* const begin = reinterpret_cast<char*>(
+            round_up(reinterpret_cast<std::size_t>(first), huge_page_size));
+        char* const end = begin + size;
+        if(begin != first)
+            ::munmap(first, static_cast<std::size_t>(begin - first));
+        if(end != first + mapped)
+            ::munmap(end, static_cast<std::size_t>(first + mapped - end));
+        ptr = begin;
+
+#ifdef MADV_HUGEPAGE
+        if(pages == huge_pages::transparent)
+            ::madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    first_touch(ptr, bytes, policy.first_touch_threads);
+    return ptr;
+}
+
+inline void deallocate_huge(void* ptr, std::size_t bytes) noexcept {
+    ::munmap(ptr, round_up(bytes, huge_page_size));
+}
+#endif
+
+} // namespace detail
+
+template <class T>
+class aligned_allocator {
+    static_assert(alignof(T) <= detail::cache_line_size,
+                  "aligned_allocator cannot align beyond a cache line");
+
+  public:
+    using value_type = T;
+
+    aligned_allocator() = default;
+
+    template <class U>
+    aligned_allocator(const aligned_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_alloc();
+        const auto bytes = n * sizeof(T);
+        return static_cast<T*>(bytes >= detail::huge_page_size
+                                   ? detail::allocate_huge(bytes)
+                                   : detail::allocate_cache_aligned(bytes));
+    }
+
+    /// Whether the `n` cells returned by allocate are already zero. Large buffers are
+    /// fresh mappings from the OS or were zeroed by first_touch, so the container does
+    /// not need to write them again.
+    static bool allocates_zeros(std::size_t n) noexcept {
+        return n * sizeof(T) >= detail::huge_page_size;
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+        const auto bytes = n * sizeof(T);
+        if(bytes >= detail::huge_page_size)
+            detail::deallocate_huge(ptr, bytes);
+        else
+            detail::deallocate_cache_aligned(ptr);
+    }
+};
+
+template <class T, class U>
+bool operator==(const aligned_allocator<T>&, const aligned_allocator<U>&) noexcept {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const aligned_allocator<T>&, const aligned_allocator<U>&) noexcept {
+    return false;
+}
@@ -0,0 +1,382 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// In-place arithmetic of histograms with numbers and arrays, for h += a, h *= a and
+// h /= a. An array with the shape of the histogram, where any axis may also have length
+// one, is broadcast against the bins without flow bins if it can be, otherwise against
+// all bins. Numbers, and other objects without a shape like nested lists, are broadcast
+// against all bins like numpy would.
+//
+// Weighted sums propagate their variance: adding a number adds its square to the
+// variance, like a fill with that weight, and scaling by a number scales the variance
+// by its square. Integer counts only take non-negative integers and cannot be divided.
+// Rows along the first axis are updated in the innermost loop, which the compiler can
+// vectorize for numbers and contiguous arrays. Rows are split between threads and the
+// GIL is released meanwhile.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <bh_python/accumulators/weighted_sum.hpp>
+#include <bh_python/histogram.hpp>
+#include <bh_python/parallel.hpp>
+
+#include <boost/histogram/accumulators/thread_safe.hpp>
+#include <boost/histogram/axis/traits.hpp>
+#include <boost/histogram/detail/axes.hpp>
+#include <boost/histogram/unlimited_storage.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace detail {
+
+enum class arithmetic_op { add, multiply, divide };
+
+inline arithmetic_op arithmetic_op_from_name(const std::string& name) {
+    if(name == "__iadd__")
+        return arithmetic_op::add;
+    if(name == "__imul__")
+        return arithmetic_op::multiply;
+    if(name == "__itruediv__" || name == "__idiv__")
+        return arithmetic_op::divide;
+    throw std::invalid_argument("unknown in-place operation " + name);
+}
+
+/// The type of the cells in the buffer of a view, unlimited storages are converted to
+/// double
+template <class S>
+struct view_cell {
+    using type = typename S::value_type;
+};
+
+template <class A>
+struct view_cell<bh::unlimited_storage<A>> {
+    using type = double;
+};
+
+/// How each type of cell is updated; `value_type` is what the other operand is
+/// converted to. Cells without a specialization do not support arithmetic.
+template <class Cell>
+struct cell_arithmetic {
+    static constexpr bool supported = false;
+    using value_type                = double;
+
+    template <class F>
+    static void visit(arithmetic_op, F&&) {}
+};
+
+template <>
+struct cell_arithmetic<double> {
+    static constexpr bool supported = true;
+    using value_type                = double;
+
+    template <class F>
+    static void visit(arithmetic_op op, F&& f) {
+        switch(op) {
+        case arithmetic_op::add:
+            f([](double& c, double x) { c += x; });
+            break;
+        case arithmetic_op::multiply:
+            f([](double& c, double x) { c *= x; });
+            break;
+        case arithmetic_op::divide:
+            f([](double& c, double x) { c /= x; });
+            break;
+        }
+    }
+};
+
+// the operand is never negative, see inplace_op; results that do not fit wrap around,
+// like numpy does for unsigned integers
+template <>
+struct cell_arithmetic<std::uint64_t> {
+    static constexpr bool supported = true;
+    using value_type                = std::int64_t;
+
+    template <class F>
+    static void visit(arithmetic_op op, F&& f) {
+        if(op == arithmetic_op::add)
+            f([](std::uint64_t& c, std::int64_t x) {
+                c += static_cast<std::uint64_t>(x);
+            });
+        else
+            f([](std::uint64_t& c, std::int64_t x) {
+                c *= static_cast<std::uint64_t>(x);
+            });
+    }
+};
+
+template <>
+struct cell_arithmetic<bh::accumulators::thread_safe<std::uint64_t>> {
+    using cell_t                    = bh::accumulators::thread_safe<std::uint64_t>;
+    static constexpr bool supported = true;
+    using value_type                = std::int64_t;
+
+    template <class F>
+    static void visit(arithmetic_op op, F&& f) {
+        if(op == arithmetic_op::add)
+            f([](cell_t& c, std::int64_t x) { c += static_cast<std::uint64_t>(x); });
+        else
+            f([](cell_t& c, std::int64_t x) {
+                c.store(c.load() * static_cast<std::uint64_t>(x));
+            });
+    }
+};
+
+template <>
+struct cell_arithmetic<accumulators::weighted_sum<double>> {
+    using cell_t                    = accumulators::weighted_sum<double>;
+    static constexpr bool supported = true;
+    using value_type                = double;
+
+    template <class F>
+    static void visit(arithmetic_op op, F&& f) {
+        switch(op) {
+        case arithmetic_op::add:
+            f([](cell_t& c, double x) {
+                c.value += x;
+                c.variance += x * x;
+            });
+            break;
+        case arithmetic_op::multiply:
+            f([](cell_t& c, double x) {
+                c.value *= x;
+                c.variance *= x * x;
+            });
+            break;
+        case arithmetic_op::divide:
+            f([](cell_t& c, double x) {
+                c.value /= x;
+                c.variance /= x * x;
+            });
+            break;
+        }
+    }
+
+    /// Weighted sums, like the view of another histogram, can only be added
+    template <class F>
+    static void visit_sums(F&& f) {
+        f([](cell_t& c, const cell_t& x) {
+            c.value += x.value;
+            c.variance += x.variance;
+        });
+    }
+};
+
+/// Call f(c, x) on every cell c of the buffer with the element x of the values at the
+/// same index, where the values are given by their byte strides along each axis of the
+/// buffer, 0 for broadcast axes
+template <class Cell, class Value, class F>
+void update_cells(const py::buffer_info& cells,
+                  const char* values,
+                  const std::vector<py::ssize_t>& strides,
+                  F f) {
+    const auto rank = static_cast<std::size_t>(cells.ndim);
+    const auto row  = rank > 0 ? static_cast<std::size_t>(cells.shape[0]) : 1;
+    std::size_t rows = 1;
+    for(std::size_t k = 1; k < rank; ++k)
+        rows *= static_cast<std::size_t>(cells.shape[k]);
+    if(row == 0 || rows == 0)
+        return;
+
+    char* const first         = static_cast<char*>(cells.ptr);
+    const py::ssize_t vstride = rank > 0 ? strides[0] : 0;
+
+    py::gil_scoped_release release;
+
+    parallel_for(
+        rows,
+        0,
+        (std::size_t{1} << 14) / row + 1,
+        [&](std::size_t begin, std::size_t end) {
+            std::vector<py::ssize_t> index(rank, 0);
+            auto rest = begin;
+            for(std::size_t k = 1; k < rank; ++k) {
+                const auto n = static_cast<std::size_t>(cells.shape[k]);
+                index[k]     = static_cast<py::ssize_t>(rest % n);
+                rest /= n;
+            }
+
+            for(auto r = begin; r < end; ++r) {
+                char* c_bytes       = first;
+                const char* v_bytes = values;
+                for(std::size_t k = 1; k < rank; ++k) {
+                    c_bytes += index[k] * cells.strides[k];
+                    v_bytes += index[k] * strides[k];
+                }
+
+                // rows of cells are contiguous
+                Cell* c = reinterpret_cast<Cell*>(c_bytes);
+                if(vstride == 0) {
+                    const Value x = *reinterpret_cast<const Value*>(v_bytes);
+                    for(std::size_t j = 0; j < row; ++j)
+                        f(c[j], x);
+                } else if(vstride == static_cast<py::ssize_t>(sizeof(Value))) {
+                    const Value* x = reinterpret_cast<const Value*>(v_bytes);
+                    for(std::size_t j = 0; j < row; ++j)
+                        f(c[j], x[j]);
+                } else {
+                    for(std::size_t j = 0; j < row; ++j)
+                        f(c[j],
+                          *reinterpret_cast<const Value*>(
+                              v_bytes + static_cast<py::ssize_t>(j) * vstride));
+                }
+
+                for(std::size_t k = 1; k < rank && ++index[k] == cells.shape[k]; ++k)
+                    index[k] = 0;
+            }
+        },
+        1);
+}
+
+/// Return the byte strides of the array along each axis of a buffer with the given
+/// shape, 0 where it is broadcast, or an empty vector if it cannot be broadcast. A
+/// `strict` array must have one axis per axis of the buffer.
+inline std::vector<py::ssize_t> broadcast_strides(const py::array& a,
+                                                  const std::vector<py::ssize_t>& shape,
+                                                  bool strict) {
+    const auto rank = shape.size();
+    const auto ndim = static_cast<std::size_t>(a.ndim());
+    if(ndim > rank || (strict && ndim != rank))
+        return {};
+    std::vector<py::ssize_t> strides(rank, 0);
+    for(auto k = rank - ndim; k < rank; ++k) {
+        const auto i = static_cast<py::ssize_t>(k - (rank - ndim));
+        if(a.shape(i) == shape[k])
+            strides[k] = a.strides(i);
+        else if(a.shape(i) != 1)
+            return {};
+    }
+    return strides;
+}
+
+/// Call f(cell, value) on the cells of the histogram with the values broadcast against
+/// them, see the top of this file
+template <class Cell, class Value, class Histogram, class F>
+void update_histogram(Histogram& h, const py::array& values, bool strict, F f) {
+    const auto& axes = bh::unsafe_access::axes(h);
+    std::vector<py::ssize_t> inner, extent;
+    bh::detail::for_each_axis(axes, [&](const auto& axis) {
+        inner.push_back(axis.size());
+        extent.push_back(bh::axis::traits::extent(axis));
+    });
+
+    if(strict && static_cast<std::size_t>(values.ndim()) != inner.size())
+        throw py::value_error(
+            py::str("Number of dimensions {} must match histogram {}")
+                .format(values.ndim(), inner.size()));
+
+    bool flow = false;
+    std::vector<py::ssize_t> strides;
+    if(strict)
+        strides = broadcast_strides(values, inner, true);
+    if(!strict || strides.size() != inner.size()) {
+        flow    = true;
+        strides = broadcast_strides(values, extent, strict);
+    }
+    if(strides.size() != extent.size()) {
+        if(strict)
+            throw py::value_error(py::str("Wrong shape {}, expected {} or {}")
+                                      .format(values.attr("shape"),
+                                              py::tuple(py::cast(inner)),
+                                              py::tuple(py::cast(extent))));
+        throw py::value_error(py::str("Cannot broadcast shape {} to {}")
+                                  .format(values.attr("shape"),
+                                          py::tuple(py::cast(extent))));
+    }
+
+    const auto guard = prepare_write(bh::unsafe_access::storage(h));
+    const auto cells = make_buffer(h, flow);
+    update_cells<Cell, Value>(
+        cells, static_cast<const char*>(values.data()), strides, f);
+}
+
+/// Whether any of the values is negative
+template <class Value>
+bool any_negative(const py::array_t<Value>& values) {
+    constexpr int flags = py::array::c_style | py::array::forcecast;
+    auto c              = py::array_t<Value, flags>::ensure(values);
+    if(!c)
+        throw py::error_already_set();
+    return std::any_of(
+        c.data(), c.data() + c.size(), [](const Value& x) { return x < 0; });
+}
+
+template <class Histogram>
+void add_weighted_sums(std::false_type, Histogram&, const py::array&, bool) {
+    throw py::type_error("Only histograms with a weight storage can add weighted sums");
+}
+
+template <class Histogram>
+void add_weighted_sums(std::true_type,
+                       Histogram& h,
+                       const py::array& other,
+                       bool strict) {
+    using cell_t = accumulators::weighted_sum<double>;
+    auto values  = py::array_t<cell_t, py::array::forcecast>::ensure(other);
+    if(!values)
+        throw py::error_already_set();
+    cell_arithmetic<cell_t>::visit_sums([&](auto f) {
+        update_histogram<cell_t, cell_t>(h, values, strict, f);
+    });
+}
+
+} // namespace detail
+
+/// Apply h += other, h *= other or h /= other, named like the Python operator, where
+/// other is a number or an array, see the top of this file
+template <class Histogram>
+void inplace_op(Histogram& h, const std::string& name, py::object other) {
+    using storage_t  = typename Histogram::storage_type;
+    using cell_t     = typename detail::view_cell<storage_t>::type;
+    using arithmetic = detail::cell_arithmetic<cell_t>;
+    using value_t    = typename arithmetic::value_type;
+
+    const auto op = detail::arithmetic_op_from_name(name);
+    if(!arithmetic::supported)
+        throw py::type_error(
+            "Arithmetic with numbers and arrays is not supported by this storage");
+
+    const bool has_shape = py::hasattr(other, "shape");
+    auto a               = py::array::ensure(other);
+    if(!a)
+        throw py::error_already_set();
+    // arrays with a shape must have one axis per axis of the histogram
+    const bool strict = has_shape && a.ndim() > 0;
+
+    if(!a.dtype().attr("names").is_none()) {
+        if(op != detail::arithmetic_op::add)
+            throw py::type_error("Weighted sums can only be added to a histogram");
+        detail::add_weighted_sums(
+            std::is_same<cell_t, accumulators::weighted_sum<double>>{}, h, a, strict);
+        return;
+    }
+
+    const char kind = a.dtype().kind();
+    if(std::is_integral<value_t>::value
+       && (op == detail::arithmetic_op::divide
+           || (kind != 'i' && kind != 'u' && kind != 'b')))
+        throw py::type_error("Histograms of integer counts only take integers and "
+                             "cannot be divided in place");
+
+    auto values = py::array_t<value_t, py::array::forcecast>::ensure(a);
+    if(!values)
+        throw py::error_already_set();
+    // checked before any cell changes, so a failed operation leaves the histogram as is
+    if(std::is_integral<value_t>::value && detail::any_negative<value_t>(values))
+        throw py::value_error("Histograms of integer counts only take non-negative "
+                              "integers");
+    arithmetic::visit(op, [&](auto f) {
+        detail::update_histogram<cell_t, value_t>(h, values, strict, f);
+    });
+}
@@ -0,0 +1,263 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Export of histograms through the Arrow C data interface, wrapped in capsules as
+// described by the Arrow PyCapsule interface, so that Arrow-based libraries can read
+// the cells without a dependency on pyarrow here.
+//
+// A histogram is exported as a struct array (a record batch) with one row per cell,
+// including flow bins, in memory order. There is one int32 column with the bin index
+// per axis, -1 being the underflow bin, followed by one column per field of the cell.
+// Cells made of a single number are exported without a copy; the export holds a
+// copy-on-write copy of the storage, so later changes to the histogram are not seen.
+// Releasing an export never needs the GIL.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <boost/histogram/detail/axes.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace arrow {
+
+/// A primitive column without nulls, whose data is kept alive by `owner`
+struct column {
+    std::string name;
+    std::string format; ///< Arrow format string, like "g" for float64
+    const void* data;
+    std::shared_ptr<const void> owner;
+};
+
+namespace detail {
+
+/// Everything an exported struct array and its schema point to. Each exported struct,
+/// including the children, holds a reference, so children may be moved out and
+/// released on their own, as the interface allows.
+struct table {
+    std::vector<column> columns;
+    std::vector<std::array<const void*, 2>> buffers;
+    const void* parent_buffers[1] = {nullptr};
+    std::vector<ArrowSchema> schemas;
+    std::vector<ArrowSchema*> schema_children;
+    std::vector<ArrowArray> arrays;
+    std::vector<ArrowArray*> array_children;
+};
+
+using table_ref = std::shared_ptr<table>;
+
+template <class Struct>
+void release(Struct* s) {
+    for(int64_t i = 0; i < s->n_children; ++i) {
+        Struct* child = s->children[i];
+        if(child->release != nullptr)
+            child->release(child);
+    }
+    // children that were not moved out live in the table, which may go away here
+    auto* ref  = static_cast<table_ref*>(s->private_data);
+    s->release = nullptr;
+    delete ref;
+}
+
+template <class Struct>
+void destroy_capsule(PyObject* capsule, const char* name) {
+    auto* s = static_cast<Struct*>(PyCapsule_GetPointer(capsule, name));
+    if(s == nullptr) {
+        PyErr_Clear();
+        return;
+    }
+    if(s->release != nullptr)
+        s->release(s);
+    delete s;
+}
+
+inline void init_schema(ArrowSchema& s, const table_ref& t, const char* format) {
+    s              = ArrowSchema{};
+    s.format       = format;
+    s.name         = "";
+    s.release      = &release<ArrowSchema>;
+    s.private_data = new table_ref(t);
+}
+
+inline void init_array(ArrowArray& a, const table_ref& t, int64_t length) {
+    a              = ArrowArray{};
+    a.length       = length;
+    a.release      = &release<ArrowArray>;
+    a.private_data = new table_ref(t);
+}
+
+} // namespace detail
+
+/// Export the columns, each with `length` values, as a struct array. Return the
+/// capsules ("arrow_schema", "arrow_array") of the Arrow PyCapsule interface.
+inline py::tuple export_table(std::vector<column> columns, int64_t length) {
+    auto t       = std::make_shared<detail::table>();
+    t->columns   = std::move(columns);
+    const auto n = t->columns.size();
+    t->buffers.resize(n);
+    t->schemas.resize(n);
+    t->arrays.resize(n);
+    t->schema_children.reserve(n);
+    t->array_children.reserve(n);
+
+    for(std::size_t i = 0; i < n; ++i) {
+        const auto& col = t->columns[i];
+        t->buffers[i]   = {nullptr, col.data};
+
+        auto& schema = t->schemas[i];
+        detail::init_schema(schema, t, col.format.c_str());
+        schema.name = col.name.c_str();
+        t->schema_children.push_back(&schema);
+
+        auto& array = t->arrays[i];
+        detail::init_array(array, t, length);
+        array.n_buffers = 2;
+        array.buffers   = t->buffers[i].data();
+        t->array_children.push_back(&array);
+    }
+
+    std::unique_ptr<ArrowSchema> schema(new ArrowSchema);
+    detail::init_schema(*schema, t, "+s");
+    schema->n_children = static_cast<int64_t>(n);
+    schema->children   = t->schema_children.data();
+
+    std::unique_ptr<ArrowArray> array(new ArrowArray);
+    detail::init_array(*array, t, length);
+    array->n_buffers  = 1;
+    array->buffers    = t->parent_buffers;
+    array->n_children = static_cast<int64_t>(n);
+    array->children   = t->array_children.data();
+
+    auto wrap = [](auto& ptr, const char* name, PyCapsule_Destructor destructor) {
+        PyObject* capsule = PyCapsule_New(ptr.get(), name, destructor);
+        if(capsule == nullptr)
+            throw py::error_already_set();
+        ptr.release();
+        return py::reinterpret_steal<py::object>(capsule);
+    };
+    auto schema_capsule = wrap(schema, "arrow_schema", [](PyObject* capsule) {
+        detail::destroy_capsule<ArrowSchema>(capsule, "arrow_schema");
+    });
+    auto array_capsule = wrap(array, "arrow_array", [](PyObject* capsule) {
+        detail::destroy_capsule<ArrowArray>(capsule, "arrow_array");
+    });
+    return py::make_tuple(schema_capsule, array_capsule);
+}
+
+/// Return the Arrow format string of a numpy scalar type
+inline std::string format_of(const py::dtype& dtype) {
+    const auto kind = dtype.kind();
+    const auto size = dtype.itemsize();
+    if(kind == 'f' && size == 8)
+        return "g";
+    if(kind == 'f' && size == 4)
+        return "f";
+    if(kind == 'u' && size == 8)
+        return "L";
+    if(kind == 'i' && size == 8)
+        return "l";
+    throw std::invalid_argument("cells of this type cannot be exported to Arrow");
+}
+
+} // namespace arrow
+
+/// Export the cells of a histogram whose storage is a shared_vector, see the top of
+/// this file. The index columns are named after `names`, one per axis.
+template <class Histogram>
+py::tuple arrow_c_array(const Histogram& h, const std::vector<std::string>& names) {
+    using value_type = typename Histogram::value_type;
+    using storage_t  = typename Histogram::storage_type;
+
+    const auto& axes = bh::unsafe_access::axes(h);
+    if(names.size() != bh::detail::axes_rank(axes))
+        throw std::invalid_argument("Expected one name per axis");
+
+    auto cells       = std::make_shared<const storage_t>(bh::unsafe_access::storage(h));
+    const auto size  = cells->size();
+    const auto* data = cells->data();
+    std::vector<arrow::column> columns;
+
+    std::size_t stride = 1;
+    unsigned rank      = 0;
+    bh::detail::for_each_axis(axes, [&](const auto& axis) {
+        const auto extent = static_cast<std::size_t>(bh::axis::traits::extent(axis));
+        const int underflow
+            = (bh::axis::traits::options(axis) & bh::axis::option::underflow) ? 1 : 0;
+        auto index = std::make_shared<std::vector<std::int32_t>>(size);
+        for(std::size_t i = 0; i < size; ++i)
+            (*index)[i] = static_cast<std::int32_t>(i / stride % extent) - underflow;
+        columns.push_back({names[rank++], "i", index->data(), index});
+        stride *= extent;
+    });
+
+    const auto dtype         = py::dtype::of<value_type>();
+    const py::object fields  = dtype.attr("fields");
+    const py::object members = dtype.attr("names");
+    if(members.is_none()) {
+        columns.push_back({"value", arrow::format_of(dtype), data, cells});
+    } else {
+        // fields are interleaved in the cells, Arrow needs one contiguous buffer each
+        for(auto member : members) {
+            const py::tuple field = fields[member];
+            const auto type       = py::cast<py::dtype>(field[0]);
+            const auto offset     = py::cast<std::size_t>(field[1]);
+            const auto width      = static_cast<std::size_t>(type.itemsize());
+            auto values = std::make_shared<std::vector<char>>(size * width);
+            const char* in = reinterpret_cast<const char*>(data) + offset;
+            for(std::size_t i = 0; i < size; ++i)
+                std::memcpy(&(*values)[i * width], in + i * sizeof(value_type), width);
+            columns.push_back({py::cast<std::string>(member),
+                               arrow::format_of(type),
+                               values->data(),
+                               values});
+        }
+    }
+
+    return arrow::export_table(std::move(columns), static_cast<int64_t>(size));
+}
@@ -216,12 +216,14 @@ py::array_t<double> edges(const A& ax, bool flow = false, bool numpy_upper = fal
         py::array_t<double> edges(
             static_cast<py::ssize_t>(ax.size() + 1 + overflow + underflow));
 
+        // write through the pointer, checked element access is slow for large axes
+        double* out = edges.mutable_data();
         for(index_type i = -underflow; i <= ax.size() + overflow; ++i)
-            edges.mutable_at(i + underflow) = ax.value(i);
+            *out++ = ax.value(i);
 
         if(numpy_upper && !std::is_same<A, axis::regular_numpy>::value) {
-            edges.mutable_at(ax.size() + underflow) = std::nextafter(
-                edges.at(ax.size() + underflow), std::numeric_limits<double>::min());
+            double& upper = edges.mutable_data()[ax.size() + underflow];
+            upper = std::nextafter(upper, std::numeric_limits<double>::min());
         }
 
         return edges;
@@ -240,8 +242,9 @@ py::array_t<double> edges(const A& ax, bool flow = false, bool numpy_upper = fal
             py::array_t<double> edges(
                 static_cast<py::ssize_t>(ax.size() + 1 + overflow));
 
+            double* out = edges.mutable_data();
             for(bh::axis::index_type i = 0; i <= ax.size() + overflow; ++i)
-                edges.mutable_at(i) = i;
+                *out++ = i;
 
             return edges;
         },
@@ -0,0 +1,209 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Layouts for the cells of dense storages when they are serialized. Histograms with
+// many bins are often mostly empty, so the cells are scanned once and saved in the
+// smallest of three layouts:
+//
+// - dense: every cell, as one flat array that shares the buffer (the legacy layout)
+// - runs: the start and length of each run of filled cells, and their values
+// - sparse: the index and the value of each filled cell
+//
+// A cell is empty if all its bytes are zero, so every layout restores the cells
+// exactly. The dense layout is kept unless another one is at most half its size,
+// because it can be pickled without a copy. It is also kept for storages below
+// 64 KiB, where little is saved, so that releases which only know the dense layout
+// can read pickles of small histograms. Loading copies whole runs at once.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <bh_python/shared_vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+enum class cell_encoding : unsigned { dense = 0, runs = 1, sparse = 2 };
+
+namespace detail {
+
+template <class T>
+bool is_empty_cell(const T& cell) {
+    static constexpr unsigned char zero[sizeof(T)] = {};
+    return std::memcmp(&cell, zero, sizeof(T)) == 0;
+}
+
+struct cell_census {
+    std::size_t filled = 0;
+    std::size_t runs   = 0;
+};
+
+template <class T>
+cell_census count_cells(const T* cells, std::size_t n) {
+    cell_census census;
+    bool in_run = false;
+    for(std::size_t i = 0; i < n; ++i) {
+        const bool filled = !is_empty_cell(cells[i]);
+        census.filled += filled;
+        census.runs += filled && !in_run;
+        in_run = filled;
+    }
+    return census;
+}
+
+/// Storages smaller than this many bytes are always saved in the dense layout
+constexpr std::size_t min_compact_bytes = std::size_t{1} << 16;
+
+template <class T>
+cell_encoding choose_encoding(const cell_census& census, std::size_t n) {
+    constexpr std::size_t index_size = sizeof(std::uint64_t);
+    const std::size_t dense          = n * sizeof(T);
+    const std::size_t runs   = census.filled * sizeof(T) + census.runs * 2 * index_size;
+    const std::size_t sparse = census.filled * (sizeof(T) + index_size);
+    if(2 * (std::min)(runs, sparse) > dense)
+        return cell_encoding::dense;
+    return runs <= sparse ? cell_encoding::runs : cell_encoding::sparse;
+}
+
+inline void check_cells(bool ok) {
+    if(!ok)
+        throw std::invalid_argument("Saved cells do not match the storage size");
+}
+
+} // namespace detail
+
+/// Save the cells as flat arrays of U, where each cell is made of sizeof(T) / sizeof(U)
+/// values, in the smallest layout
+template <class U, class Archive, class T, class A>
+void save_cells(Archive& ar, const shared_vector<T, A>& v) {
+    static_assert(sizeof(T) % sizeof(U) == 0, "cell must be made of whole values");
+    constexpr std::size_t values_per_cell = sizeof(T) / sizeof(U);
+
+    const T* const cells = v.data();
+    const auto n         = v.size();
+    // small storages are not even scanned
+    if(n * sizeof(T) < detail::min_compact_bytes) {
+        ar << share_buffer<U>(v);
+        return;
+    }
+
+    const auto census   = detail::count_cells(cells, n);
+    const auto encoding = detail::choose_encoding<T>(census, n);
+    if(encoding == cell_encoding::dense) {
+        ar << share_buffer<U>(v);
+        return;
+    }
+
+    ar << static_cast<unsigned>(encoding);
+    ar << n;
+    py::array_t<U> values(static_cast<py::ssize_t>(census.filled * values_per_cell));
+    auto* out = values.mutable_data();
+
+    if(encoding == cell_encoding::runs) {
+        py::array_t<std::uint64_t> starts(static_cast<py::ssize_t>(census.runs));
+        py::array_t<std::uint64_t> lengths(static_cast<py::ssize_t>(census.runs));
+        auto* start  = starts.mutable_data();
+        auto* length = lengths.mutable_data();
+        for(std::size_t i = 0; i < n;) {
+            if(detail::is_empty_cell(cells[i])) {
+                ++i;
+                continue;
+            }
+            const auto first = i;
+            while(i < n && !detail::is_empty_cell(cells[i]))
+                ++i;
+            *start++  = first;
+            *length++ = i - first;
+            std::memcpy(out, cells + first, (i - first) * sizeof(T));
+            out += (i - first) * values_per_cell;
+        }
+        ar << starts;
+        ar << lengths;
+    } else {
+        py::array_t<std::uint64_t> indices(static_cast<py::ssize_t>(census.filled));
+        auto* index = indices.mutable_data();
+        for(std::size_t i = 0; i < n; ++i) {
+            if(!detail::is_empty_cell(cells[i])) {
+                *index++ = i;
+                std::memcpy(out, cells + i, sizeof(T));
+                out += values_per_cell;
+            }
+        }
+        ar << indices;
+    }
+    ar << values;
+}
+
+/// Load cells saved by save_cells in any layout
+template <class U, class Archive, class T, class A>
+void load_cells(Archive& ar, shared_vector<T, A>& v) {
+    static_assert(sizeof(T) % sizeof(U) == 0, "cell must be made of whole values");
+    constexpr std::size_t values_per_cell = sizeof(T) / sizeof(U);
+
+    if(py::isinstance<py::array>(ar.peek())) {
+        py::object a;
+        ar >> a;
+        load_buffer<U>(v, std::move(a));
+        return;
+    }
+
+    unsigned encoding;
+    std::size_t n;
+    ar >> encoding;
+    ar >> n;
+
+    shared_vector<T, A> cells;
+    cells.resize(n);
+    T* const out = cells.data();
+
+    if(encoding == static_cast<unsigned>(cell_encoding::runs)) {
+        py::array_t<std::uint64_t> starts;
+        py::array_t<std::uint64_t> lengths;
+        py::array_t<U> values;
+        ar >> starts;
+        ar >> lengths;
+        ar >> values;
+        detail::check_cells(starts.size() == lengths.size());
+
+        const auto* in     = values.data();
+        const auto* end    = in + values.size();
+        const auto* start  = starts.data();
+        const auto* length = lengths.data();
+        for(py::ssize_t r = 0; r < starts.size(); ++r) {
+            const auto first = static_cast<std::size_t>(start[r]);
+            const auto count = static_cast<std::size_t>(length[r]);
+            detail::check_cells(first <= n && count <= n - first
+                                && count * values_per_cell
+                                       <= static_cast<std::size_t>(end - in));
+            std::memcpy(out + first, in, count * sizeof(T));
+            in += count * values_per_cell;
+        }
+    } else if(encoding == static_cast<unsigned>(cell_encoding::sparse)) {
+        py::array_t<std::uint64_t> indices;
+        py::array_t<U> values;
+        ar >> indices;
+        ar >> values;
+        const auto filled = static_cast<std::size_t>(indices.size());
+        detail::check_cells(static_cast<std::size_t>(values.size())
+                            == filled * values_per_cell);
+
+        const auto* in    = values.data();
+        const auto* index = indices.data();
+        for(std::size_t j = 0; j < filled; ++j) {
+            detail::check_cells(index[j] < n);
+            std::memcpy(out + index[j], in + j * values_per_cell, sizeof(T));
+        }
+    } else {
+        throw std::invalid_argument("Unknown cell encoding "
+                                    + std::to_string(encoding));
+    }
+
+    v.swap(cells);
+}
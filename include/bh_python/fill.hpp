@@ -8,6 +8,7 @@
 #include <bh_python/pybind11.hpp>
 
 #include <bh_python/axis.hpp>
+#include <bh_python/histogram.hpp>
 #include <bh_python/kwargs.hpp>
 #include <bh_python/overload.hpp>
 #include <bh_python/vector_string_caster.hpp>
@@ -154,7 +155,8 @@ void fill_impl(bh::detail::accumulator_traits_holder<true>,
     none_only_arg(kwargs, "sample");
     finalize_args(kwargs);
 
-    // releasing gil here is safe, we don't manipulate refcounts
+    // releasing gil here is safe, we don't manipulate refcounts and the storage is
+    // already private and locked, see fill
     py::gil_scoped_release lock;
     variant::visit(
         overload([&h, &vargs](const variant::monostate&) { h.fill(vargs); },
@@ -176,7 +178,8 @@ void fill_impl(bh::detail::accumulator_traits_holder<true, const double&>,
     if(sarray.ndim() != 1)
         throw std::invalid_argument("Sample array must be 1D");
 
-    // releasing gil here is safe, we don't manipulate refcounts
+    // releasing gil here is safe, we don't manipulate refcounts and the storage is
+    // already private and locked, see fill
     py::gil_scoped_release lock;
     variant::visit(
         overload([&h, &vargs, &sarray](
@@ -192,6 +195,10 @@ void fill_impl(bh::detail::accumulator_traits_holder<true, const double&>,
 template <class Histogram>
 Histogram& fill(Histogram& self, py::args args, py::kwargs kwargs) {
     using value_type = typename Histogram::value_type;
+    // filling writes through operator[], which records the cells it reaches, see
+    // shared_vector::take_changes; the lock keeps copies out until the fill is done,
+    // also from threads that hold the GIL
+    const auto guard = prepare_write(bh::unsafe_access::storage(self), false);
     detail::fill_impl(bh::detail::accumulator_traits<value_type>{},
                       self,
                       detail::get_vargs(bh::unsafe_access::axes(self), args),
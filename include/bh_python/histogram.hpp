@@ -10,11 +10,21 @@
 #include <bh_python/accumulators/mean.hpp>
 #include <bh_python/accumulators/weighted_mean.hpp>
 #include <bh_python/accumulators/weighted_sum.hpp>
+#include <bh_python/parallel.hpp>
+#include <bh_python/shared_vector.hpp>
 
 #include <boost/histogram/detail/axes.hpp>
 #include <boost/histogram/histogram.hpp>
 #include <boost/histogram/unsafe_access.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 namespace pybind11 {
 
 /// The descriptor for atomic_* is the same as the descriptor for *, as long this uses
@@ -71,8 +81,8 @@ struct double_converter {
 
 /// Build and return a buffer over the current data.
 /// Flow controls whether under/over flow bins are present
-template <class A, class T>
-py::buffer_info make_buffer(bh::histogram<A, bh::dense_storage<T>>& h, bool flow) {
+template <class A, class C>
+py::buffer_info make_buffer(bh::histogram<A, bh::storage_adaptor<C>>& h, bool flow) {
     const auto& axes = bh::unsafe_access::axes(h);
     auto& storage    = bh::unsafe_access::storage(h);
     return detail::make_buffer_impl(axes, flow, &storage[0]);
@@ -96,6 +106,288 @@ py::buffer_info make_buffer(bh::histogram<A, bh::unlimited_storage<Allocator>>&
     return detail::make_buffer_impl(axes, flow, static_cast<double*>(buffer.ptr));
 }
 
+/// Return the object that keeps a view of the histogram alive. Storages that share
+/// their buffer between copies are pinned until the view is gone, so that writes to the
+/// view never leak into copies.
+template <class S>
+py::object make_view_owner(py::object self, S&) {
+    return self;
+}
+
+template <class T, class A>
+py::object make_view_owner(py::object self,
+                           bh::storage_adaptor<shared_vector<T, A>>& storage) {
+    struct view_owner {
+        py::object histogram;
+        std::shared_ptr<void> pin;
+    };
+    return py::capsule(new view_owner{std::move(self), storage.pin()},
+                       [](void* ptr) { delete static_cast<view_owner*>(ptr); });
+}
+
+/// Keep the buffer of storages that share it between copies private for good, for
+/// memory exported through the buffer protocol, which cannot tell when it is released
+template <class S>
+void pin_storage(S&) {}
+
+template <class T, class A>
+void pin_storage(bh::storage_adaptor<shared_vector<T, A>>& storage) {
+    storage.pin_forever();
+}
+
+/// Make the buffer of storages that share it between copies private and mark the cells
+/// as changed, see shared_vector::prepare_write. Every operation that writes cells does
+/// this once before it starts, writing through the storage does not check it, and keeps
+/// the returned lock until it is done. Filling also does this first, since it may not
+/// throw once it started writing.
+template <class S>
+std::unique_lock<std::mutex> prepare_write(S&, bool = true) {
+    return {};
+}
+
+template <class T, class A>
+std::unique_lock<std::mutex>
+prepare_write(bh::storage_adaptor<shared_vector<T, A>>& storage,
+              bool every_cell = true) {
+    return storage.prepare_write(every_cell);
+}
+
+/// True for storages that can use memory from numpy arrays
+template <class S>
+struct is_adopting_storage : std::false_type {};
+
+template <class T, class A>
+struct is_adopting_storage<bh::storage_adaptor<shared_vector<T, A>>>
+    : std::integral_constant<bool, !bh::accumulators::is_thread_safe<T>::value> {};
+
+namespace detail {
+
+/// Throw unless the array has the shape of the view with flow bins
+template <class Axes>
+void check_buffer_shape(const Axes& axes, const py::array& a) {
+    if(static_cast<unsigned>(a.ndim()) != bh::detail::axes_rank(axes))
+        throw py::value_error("The array must have one dimension per axis");
+    py::ssize_t i = 0;
+    bh::detail::for_each_axis(axes, [&a, &i](const auto& axis) {
+        if(a.shape(i++) != bh::axis::traits::extent(axis))
+            throw py::value_error(
+                "The array must have the shape of the view with flow bins");
+    });
+}
+
+template <class Histogram>
+bool adopt_buffer(std::false_type, Histogram&, const py::object&) {
+    return false;
+}
+
+/// Use the memory of the array as the storage if it is a Fortran-ordered array of the
+/// storage type, and a read-only array is only copied on the first write
+template <class Histogram>
+bool adopt_buffer(std::true_type, Histogram& h, const py::object& input) {
+    using value_type = typename Histogram::value_type;
+    using array_t    = py::array_t<value_type, py::array::f_style>;
+
+    if(!array_t::check_(input))
+        return false;
+    auto a           = py::reinterpret_borrow<array_t>(input);
+    const auto& axes = bh::unsafe_access::axes(h);
+    check_buffer_shape(axes, a);
+    if(!can_adopt<value_type>(a))
+        return false;
+
+    auto* ptr = const_cast<value_type*>(a.data());
+    bh::unsafe_access::storage(h).adopt(
+        ptr, bh::detail::bincount(axes), make_python_owner(a), true, a.writeable());
+    return true;
+}
+
+} // namespace detail
+
+/// Make a histogram from an array with the shape of the view with flow bins. Storages
+/// that can adopt memory use the array directly if possible, see detail::adopt_buffer;
+/// otherwise the array is copied, converting the type if needed.
+template <class Histogram>
+Histogram histogram_from_buffer(const typename Histogram::axes_type& axes,
+                                py::object input) {
+    using value_type = typename Histogram::value_type;
+    using storage_t  = typename Histogram::storage_type;
+
+    Histogram h;
+    bh::unsafe_access::axes(h)   = axes;
+    bh::unsafe_access::offset(h) = bh::detail::offset(axes);
+    if(detail::adopt_buffer(is_adopting_storage<storage_t>{}, h, input))
+        return h;
+
+    auto a = py::array_t<value_type, py::array::f_style | py::array::forcecast>::ensure(
+        input);
+    if(!a)
+        throw py::error_already_set();
+    detail::check_buffer_shape(axes, a);
+    const auto size = bh::detail::bincount(axes);
+    auto& storage   = bh::unsafe_access::storage(h);
+    storage.reset(size);
+    std::copy(a.data(), a.data() + size, storage.begin());
+    return h;
+}
+
+/// Add the cells of a histogram with the same axes. Storages without proxies are added
+/// without holding the GIL, after the axes, which may hold Python metadata, are
+/// compared.
+template <class A, class S>
+void merge(bh::histogram<A, S>& self, const bh::histogram<A, S>& other) {
+    self += other;
+}
+
+template <class A, class C>
+void merge(bh::histogram<A, bh::storage_adaptor<C>>& self,
+           const bh::histogram<A, bh::storage_adaptor<C>>& other) {
+    if(!bh::detail::axes_equal(bh::unsafe_access::axes(self),
+                               bh::unsafe_access::axes(other)))
+        throw std::invalid_argument("axes of histograms differ");
+
+    auto& cells          = bh::unsafe_access::storage(self);
+    const auto& cells_in = bh::unsafe_access::storage(other);
+    const auto guard     = prepare_write(cells);
+
+    py::gil_scoped_release release;
+    auto it = cells_in.begin();
+    for(auto&& x : cells)
+        x += *it++;
+}
+
+/// Sum histograms with the same axes into a new histogram. Storages without proxies are
+/// summed into one copy of the first histogram, with the cells split between threads
+/// and the GIL released. Each thread adds all inputs block by block, so that the output
+/// block stays in cache.
+template <class A, class S>
+bh::histogram<A, S> sum_histograms(const std::vector<const bh::histogram<A, S>*>& hists,
+                                   unsigned /* threads */) {
+    bh::histogram<A, S> result(*hists.front());
+    for(auto it = hists.begin() + 1; it != hists.end(); ++it)
+        result += **it;
+    return result;
+}
+
+template <class A, class C>
+bh::histogram<A, bh::storage_adaptor<C>> sum_histograms(
+    const std::vector<const bh::histogram<A, bh::storage_adaptor<C>>*>& hists,
+    unsigned threads) {
+    constexpr std::size_t block = 4096;
+
+    const auto& axes = bh::unsafe_access::axes(*hists.front());
+    for(const auto* h : hists)
+        if(!bh::detail::axes_equal(axes, bh::unsafe_access::axes(*h)))
+            throw std::invalid_argument("axes of histograms differ");
+
+    auto result = *hists.front();
+    auto& cells      = bh::unsafe_access::storage(result);
+    const auto guard = prepare_write(cells);
+
+    py::gil_scoped_release release;
+    const auto out = cells.begin();
+    parallel_for(cells.size(), threads, 4 * block, [&](std::size_t i, std::size_t end) {
+        for(; i < end; i += block) {
+            const auto stop = (std::min)(i + block, end);
+            for(auto it = hists.begin() + 1; it != hists.end(); ++it) {
+                const auto in = bh::unsafe_access::storage(**it).begin();
+                for(auto k = i; k < stop; ++k)
+                    out[k] += in[k];
+            }
+        }
+    });
+    return result;
+}
+
+/// Return a read-only view with flow bins over a copy of the storage. The copy shares
+/// the buffer until the histogram is changed, so this is cheap and the view stays valid
+/// and unchanged while the histogram is filled.
+template <class Histogram>
+py::array shared_view(const Histogram& h) {
+    using value_type = typename Histogram::value_type;
+
+    const auto& axes = bh::unsafe_access::axes(h);
+    std::vector<py::ssize_t> shape;
+    bh::detail::for_each_axis(axes, [&shape](const auto& axis) {
+        shape.push_back(bh::axis::traits::extent(axis));
+    });
+    auto flat = share_buffer<value_type>(bh::unsafe_access::storage(h));
+    return flat.attr("reshape")(py::cast(shape), "order"_a = "F");
+}
+
+/// Return the cells changed since the previous call as a tuple of flat indices into the
+/// view with flow bins, in Fortran order, and the new contents of these cells. If every
+/// cell may have changed, the indices are None and all cells are returned.
+template <class Histogram>
+py::tuple take_changes(Histogram& h) {
+    using value_type = typename Histogram::value_type;
+
+    auto& storage = bh::unsafe_access::storage(h);
+    std::vector<std::size_t> cells;
+    if(storage.take_changes(cells))
+        return py::make_tuple(py::none(), share_buffer<value_type>(storage));
+
+    // reading through a const reference is not recorded as a change
+    const auto& cells_in = bh::unsafe_access::storage(static_cast<const Histogram&>(h));
+    const auto n         = static_cast<py::ssize_t>(cells.size());
+    py::array_t<std::uint64_t> indices(n);
+    py::array_t<value_type> values(n);
+    auto* index = indices.mutable_data();
+    auto* value = values.mutable_data();
+    for(const auto cell : cells) {
+        *index++ = cell;
+        *value++ = cells_in[cell];
+    }
+    return py::make_tuple(indices, values);
+}
+
+/// Set the cells at the flat indices to the values, see take_changes. All cells are
+/// set if the indices are None.
+template <class Histogram>
+void apply_changes(Histogram& h, const py::object& indices, const py::object& values) {
+    using value_type = typename Histogram::value_type;
+    using index_t    = std::uint64_t;
+    constexpr int flags = py::array::c_style | py::array::forcecast;
+
+    auto v = py::array_t<value_type, flags>::ensure(values);
+    if(!v)
+        throw py::error_already_set();
+    auto& storage = bh::unsafe_access::storage(h);
+    const auto n  = static_cast<std::size_t>(v.size());
+
+    if(indices.is_none()) {
+        if(n != storage.size())
+            throw py::value_error("Expected one value per cell");
+        const auto guard = prepare_write(storage);
+        std::copy(v.data(), v.data() + n, storage.begin());
+        return;
+    }
+
+    auto i = py::array_t<index_t, flags>::ensure(indices);
+    if(!i)
+        throw py::error_already_set();
+    if(static_cast<std::size_t>(i.size()) != n)
+        throw py::value_error("Expected one value per index");
+    const index_t* const first = i.data();
+    if(std::any_of(first, first + n, [&storage](index_t k) {
+           return k >= storage.size();
+       }))
+        throw py::index_error("Cell index out of range");
+    const auto guard = prepare_write(storage, false);
+    for(std::size_t k = 0; k < n; ++k)
+        storage[static_cast<std::size_t>(first[k])] = v.data()[k];
+}
+
+/// Return a number that changes whenever the cells may have changed, or None if that
+/// cannot be told, for example while a writable view is alive
+template <class Histogram>
+py::object storage_version(const Histogram& h) {
+    const auto& storage = bh::unsafe_access::storage(h);
+    const auto guard    = storage.lock();
+    if(!storage.knows_version())
+        return py::none();
+    return py::int_(storage.version());
+}
+
 /// Compute the bin of an array from a runtime list
 /// For example, [1,3,2] will return that bin of an array
 template <class F, int Opt>
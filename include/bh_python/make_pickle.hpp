@@ -44,16 +44,21 @@
 
 #include <bh_python/pybind11.hpp>
 
+#include <bh_python/cell_encoding.hpp>
 #include <bh_python/metadata.hpp>
+#include <bh_python/shared_vector.hpp>
 
 #include <boost/assert.hpp>
 #include <boost/core/nvp.hpp>
+#include <boost/histogram/axis/category.hpp>
 #include <boost/histogram/detail/array_wrapper.hpp>
 #include <boost/mp11/function.hpp> // mp_or
 #include <boost/mp11/utility.hpp>  // mp_valid
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -73,6 +78,11 @@ namespace serialization {
 // provide default implementation of boost::serialization::version
 template <class>
 struct version : std::integral_constant<int, 0> {};
+
+// version 1 saves the values as one blob of UTF-8 bytes, see save below
+template <class M, class O, class A>
+struct version<bh::axis::category<std::string, M, O, A>>
+    : std::integral_constant<int, 1> {};
 } // namespace serialization
 } // namespace boost
 
@@ -119,14 +129,83 @@ void serialize(Archive& ar, T& t, unsigned version) {
     split_serialize(typename Archive::is_loading{}, ar, t, version);
 }
 
-// builds a tuple of Python primitives from C++ primitives
+template <class Archive, class M, class O, class A>
+void save(Archive& ar,
+          const bh::axis::category<std::string, M, O, A>& ax,
+          unsigned /* version */) {
+    // one blob of UTF-8 bytes and the offsets of the values in it, instead of a str per
+    // value, so that an axis with many categories is saved and loaded quickly
+    const auto n = static_cast<std::size_t>(ax.size());
+    py::array_t<std::uint64_t> offsets(static_cast<py::ssize_t>(n + 1));
+    auto* offset = offsets.mutable_data();
+    offset[0]    = 0;
+    for(std::size_t i = 0; i < n; ++i)
+        offset[i + 1] = offset[i] + ax.value(static_cast<int>(i)).size();
+
+    py::array_t<std::uint8_t> blob(static_cast<py::ssize_t>(offset[n]));
+    auto* out = reinterpret_cast<char*>(blob.mutable_data());
+    for(std::size_t i = 0; i < n; ++i) {
+        const auto& item = ax.value(static_cast<int>(i));
+        out              = std::copy(item.begin(), item.end(), out);
+    }
+
+    ar << blob;
+    ar << offsets;
+    ar << ax.metadata();
+}
+
+template <class Archive, class M, class O, class A>
+void load(Archive& ar, bh::axis::category<std::string, M, O, A>& ax, unsigned version) {
+    if(version > 1)
+        throw std::invalid_argument(
+            "Category axis was saved by a newer boost-histogram (version "
+            + std::to_string(version) + "), please upgrade");
+
+    std::vector<std::string, A> values;
+    if(version == 0) {
+        // a size and a str per value
+        ar >> values;
+    } else {
+        py::array_t<std::uint8_t> blob;
+        py::array_t<std::uint64_t> offsets;
+        ar >> blob;
+        ar >> offsets;
+
+        const auto* offset = offsets.data();
+        const auto n       = static_cast<std::size_t>(offsets.size());
+        if(n == 0 || offset[n - 1] > static_cast<std::uint64_t>(blob.size()))
+            throw std::invalid_argument("String offsets do not match the data");
+        const auto* in = reinterpret_cast<const char*>(blob.data());
+
+        values.resize(n - 1);
+        for(std::size_t i = 0; i < values.size(); ++i) {
+            if(offset[i] > offset[i + 1])
+                throw std::invalid_argument("String offsets must not decrease");
+            values[i].assign(in + offset[i], in + offset[i + 1]);
+        }
+    }
+
+    M meta;
+    ar >> meta;
+    ax = bh::axis::category<std::string, M, O, A>(
+        values.begin(), values.end(), std::move(meta));
+}
+
+// builds a tuple of Python primitives from C++ primitives; the primitives are collected
+// first and the tuple is made once in finish(), so saving is linear in their number
 class tuple_oarchive {
   public:
     using is_saving  = std::true_type;
     using is_loading = std::false_type;
 
-    tuple_oarchive(py::tuple& tup)
-        : tup_(tup) {}
+    /// Move everything saved so far into a tuple of exactly the right size
+    py::tuple finish() {
+        py::tuple tup(items_.size());
+        for(std::size_t i = 0; i < items_.size(); ++i)
+            unchecked_set(tup, i, std::move(items_[i]));
+        items_.clear();
+        return tup;
+    }
 
     template <class T>
     tuple_oarchive& operator&(boost::nvp<T> t) {
@@ -162,8 +241,7 @@ class tuple_oarchive {
     }
 
     tuple_oarchive& operator<<(const py::object& obj) {
-        // maybe use growth factor 1.6 and shrink tuple to final size in destructor?
-        tup_ = tup_ + py::make_tuple(obj);
+        items_.push_back(obj);
         return *this;
     }
 
@@ -172,7 +250,8 @@ class tuple_oarchive {
     }
 
     tuple_oarchive& operator<<(py::object&& obj) {
-        return operator<<(static_cast<const py::object&>(obj));
+        items_.push_back(std::move(obj));
+        return *this;
     }
 
     // put specializations here that side-step normal serialization
@@ -193,18 +272,18 @@ class tuple_oarchive {
         return operator<<(static_cast<const py::object&>(a));
     }
 
-    template <class T>
+    template <class T, class A>
     std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_oarchive&>
-    operator<<(const std::vector<T>& v) {
+    operator<<(const std::vector<T, A>& v) {
         // fast version for vector of arithmetic types
         py::array_t<T> a(static_cast<py::ssize_t>(v.size()), v.data());
         this->operator<<(static_cast<const py::object&>(a));
         return *this;
     }
 
-    template <class T>
+    template <class T, class A>
     std::enable_if_t<std::is_arithmetic<T>::value == false, tuple_oarchive&>
-    operator<<(const std::vector<T>& v) {
+    operator<<(const std::vector<T, A>& v) {
         // generic version
         this->operator<<(v.size());
         for(auto&& item : v)
@@ -212,6 +291,16 @@ class tuple_oarchive {
         return *this;
     }
 
+    template <class T, class A>
+    std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_oarchive&>
+    operator<<(const shared_vector<T, A>& v) {
+        // mostly empty buffers are saved sparsely, otherwise this is the same format
+        // as std::vector, but the array shares the buffer, which pickle protocol 5 can
+        // pass out of band
+        save_cells<T>(*this, v);
+        return *this;
+    }
+
     template <class T>
     std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_oarchive&>
     operator<<(const bh::detail::array_wrapper<T>& w) {
@@ -231,7 +320,7 @@ class tuple_oarchive {
     }
 
   private:
-    py::tuple& tup_;
+    std::vector<py::object> items_;
 };
 
 class tuple_iarchive {
@@ -245,6 +334,12 @@ class tuple_iarchive {
     // no object tracking
     void reset_object_address(const void*, const void*){};
 
+    /// The next object, without consuming it
+    py::object peek() const {
+        BOOST_ASSERT(cur_ < tup_.size());
+        return tup_[cur_];
+    }
+
     template <class T>
     tuple_iarchive& operator&(boost::nvp<T> t) {
         return operator>>(t.value());
@@ -301,9 +396,9 @@ class tuple_iarchive {
         return operator>>(static_cast<py::object&>(a));
     }
 
-    template <class T>
+    template <class T, class A>
     std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_iarchive&>
-    operator>>(std::vector<T>& v) {
+    operator>>(std::vector<T, A>& v) {
         // fast version for vector of arithmetic types
         py::array_t<T> a;
         this->operator>>(a);
@@ -313,9 +408,9 @@ class tuple_iarchive {
         return *this;
     }
 
-    template <class T>
+    template <class T, class A>
     std::enable_if_t<std::is_arithmetic<T>::value == false, tuple_iarchive&>
-    operator>>(std::vector<T>& v) {
+    operator>>(std::vector<T, A>& v) {
         // generic version
         std::size_t new_size;
         this->operator>>(new_size);
@@ -325,6 +420,14 @@ class tuple_iarchive {
         return *this;
     }
 
+    template <class T, class A>
+    std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_iarchive&>
+    operator>>(shared_vector<T, A>& v) {
+        // a dense numpy array becomes the buffer if possible, so nothing is copied
+        load_cells<T>(*this, v);
+        return *this;
+    }
+
     template <class T>
     std::enable_if_t<std::is_arithmetic<T>::value == true, tuple_iarchive&>
     operator>>(bh::detail::array_wrapper<T>& w) {
@@ -357,10 +460,9 @@ template <class T>
 decltype(auto) make_pickle() {
     return py::pickle(
         [](const T& obj) {
-            py::tuple tup;
-            tuple_oarchive oa{tup};
+            tuple_oarchive oa;
             oa << obj;
-            return tup;
+            return oa.finish();
         },
         [](py::tuple tup) {
             tuple_iarchive ia{tup};
@@ -0,0 +1,337 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// A vector-like container for bh::storage_adaptor whose memory is a file mapped with
+// mmap. The OS pages cold regions in and out, so the histogram does not need to fit
+// into RAM, and reopening the same file with the same axes gives back the stored counts
+// without reading them eagerly. The memory can also be a POSIX shared-memory segment,
+// which other processes attach to by name to fill the same histogram in place.
+//
+// A mapped_vector that has a path but no size is a "prototype": it only remembers
+// where the data should live. The file is created or opened on the first resize, which
+// is what the histogram constructor does when it sizes the storage. Copies of a mapped
+// vector that holds data are plain in-memory buffers, so copying a histogram never
+// aliases the file.
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Where the memory of a named mapped_vector lives
+enum class mapped_backing {
+    file,         ///< a regular file on disk
+    shared_memory ///< a POSIX shared-memory segment, other processes attach by name
+};
+
+namespace detail {
+
+#ifndef _WIN32
+inline int open_backing(const std::string& path, mapped_backing backing, int flags) {
+    if(backing == mapped_backing::shared_memory)
+        return ::shm_open(path.c_str(), flags, 0600);
+    return ::open(path.c_str(), flags, 0644);
+}
+
+/// Map `bytes` bytes of the open file
+inline void* map_fd(int fd, const std::string& path, std::size_t bytes) {
+    void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(ptr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "cannot map " + path);
+    return ptr;
+}
+
+/// Map `path` with exactly `bytes` bytes. If `create`, the file is created if it does
+/// not exist and sized if it is empty; otherwise it must already have the size.
+inline void* map_file(const std::string& path,
+                      mapped_backing backing,
+                      std::size_t bytes,
+                      bool create = true) {
+    const int fd = open_backing(path, backing, create ? O_RDWR | O_CREAT : O_RDWR);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "cannot stat " + path);
+    }
+
+    // some systems round shared-memory segments up to full pages
+    const auto file_bytes = static_cast<std::size_t>(st.st_size);
+    const auto slack      = backing == mapped_backing::shared_memory
+                                ? static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))
+                                : std::size_t{1};
+    if(file_bytes < bytes || file_bytes - bytes >= slack) {
+        // a new (empty) file is sized here, an existing one must match the histogram
+        if(file_bytes != 0 || !create) {
+            ::close(fd);
+            throw std::invalid_argument(path + " has " + std::to_string(file_bytes)
+                                        + " bytes, but the histogram needs "
+                                        + std::to_string(bytes) + " bytes");
+        }
+        if(::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(
+                err, std::generic_category(), "cannot size " + path);
+        }
+    }
+
+    try {
+        void* ptr = map_fd(fd, path, bytes);
+        // the mapping keeps the file open
+        ::close(fd);
+        return ptr;
+    } catch(...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+inline void unmap_file(void* ptr, std::size_t bytes) noexcept { ::munmap(ptr, bytes); }
+
+/// Change the size of a mapped file, keeping the contents that still fit. The old
+/// mapping is only removed once the new one exists, so it is still valid if this
+/// throws.
+inline void* remap_file(const std::string& path,
+                        mapped_backing backing,
+                        void* ptr,
+                        std::size_t old_bytes,
+                        std::size_t new_bytes) {
+    const int fd = open_backing(path, backing, O_RDWR);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    const auto size = [fd, &path](std::size_t bytes) {
+        if(::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+            throw std::system_error(
+                errno, std::generic_category(), "cannot resize " + path);
+    };
+
+    // grow before mapping so that every page of the new mapping is backed, shrink only
+    // after it, so that a failure leaves the file as the old mapping expects it
+    void* fresh = nullptr;
+    try {
+        if(new_bytes > old_bytes)
+            size(new_bytes);
+        fresh = map_fd(fd, path, new_bytes);
+        if(new_bytes < old_bytes)
+            size(new_bytes);
+    } catch(...) {
+        if(fresh != nullptr)
+            unmap_file(fresh, new_bytes);
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    unmap_file(ptr, old_bytes);
+    return fresh;
+}
+
+/// Remove a shared-memory segment; processes that have it mapped keep their mapping
+inline void unlink_shared(const std::string& path) {
+    if(::shm_unlink(path.c_str()) != 0)
+        throw std::system_error(
+            errno, std::generic_category(), "cannot unlink " + path);
+}
+#else
+inline void* map_file(const std::string&, mapped_backing, std::size_t, bool = true) {
+    throw std::runtime_error("File-backed storages are not supported on Windows");
+}
+
+inline void unmap_file(void*, std::size_t) noexcept {}
+
+inline void* remap_file(
+    const std::string& path, mapped_backing backing, void*, std::size_t, std::size_t) {
+    return map_file(path, backing, 0);
+}
+
+inline void unlink_shared(const std::string&) {
+    throw std::runtime_error("Shared-memory storages are not supported on Windows");
+}
+#endif
+
+/// POSIX shared-memory names start with a single slash
+inline std::string shared_name(std::string name) {
+    if(name.empty() || name.front() != '/')
+        name.insert(name.begin(), '/');
+    return name;
+}
+
+} // namespace detail
+
+template <class T>
+class mapped_vector {
+    static_assert(std::is_standard_layout<T>::value
+                      && std::is_trivially_destructible<T>::value,
+                  "mapped_vector requires types that can live in a raw file");
+
+  public:
+    using value_type      = T;
+    using allocator_type  = std::allocator<T>; // required by storage_adaptor, unused
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using iterator        = T*;
+    using const_iterator  = const T*;
+
+    mapped_vector() = default;
+    explicit mapped_vector(const allocator_type&) {}
+
+    /// Prototype that maps `path` once it is sized
+    explicit mapped_vector(std::string path,
+                           mapped_backing backing = mapped_backing::file)
+        : path_(backing == mapped_backing::shared_memory && !path.empty()
+                    ? detail::shared_name(std::move(path))
+                    : std::move(path))
+        , backing_(backing) {}
+
+    mapped_vector(const mapped_vector& other)
+        : path_(other.size_ == 0 ? other.path_ : std::string{})
+        , backing_(other.size_ == 0 ? other.backing_ : mapped_backing::file) {
+        // a copy of a filled storage lives in memory, it must not alias the file
+        resize(other.size_);
+        std::copy(other.begin(), other.end(), begin());
+    }
+
+    mapped_vector(mapped_vector&& other) noexcept { swap(other); }
+
+    mapped_vector& operator=(const mapped_vector& other) {
+        if(this != &other) {
+            mapped_vector tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    mapped_vector& operator=(mapped_vector&& other) noexcept {
+        mapped_vector tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    ~mapped_vector() { release(); }
+
+    void swap(mapped_vector& other) noexcept {
+        using std::swap;
+        swap(path_, other.path_);
+        swap(backing_, other.backing_);
+        swap(mapped_, other.mapped_);
+        swap(data_, other.data_);
+        swap(size_, other.size_);
+    }
+
+    /// Resize; a prototype opens (or creates) its file here. Cells that are added are
+    /// zero, which is the default value of every type stored in a mapped storage.
+    void resize(size_type n) {
+        if(n == size_)
+            return;
+
+        const auto bytes     = n * sizeof(T);
+        const auto old_bytes = size_ * sizeof(T);
+
+        if(!path_.empty()) {
+            if(n == 0) {
+                release();
+            } else {
+                void* ptr
+                    = mapped_
+                          ? detail::remap_file(path_, backing_, data_, old_bytes, bytes)
+                          : detail::map_file(path_, backing_, bytes);
+                data_   = static_cast<T*>(ptr);
+                mapped_ = true;
+            }
+            size_ = n;
+            return;
+        }
+
+        T* ptr = nullptr;
+        if(n > 0) {
+            ptr = static_cast<T*>(std::calloc(n, sizeof(T)));
+            if(ptr == nullptr)
+                throw std::bad_alloc();
+            std::copy(data_, data_ + (std::min)(n, size_), ptr);
+        }
+        release();
+        data_ = ptr;
+        size_ = n;
+    }
+
+    void resize(size_type n, const_reference) { resize(n); }
+
+    /// Map the existing file or segment of a prototype with `n` cells. Unlike resize,
+    /// this never creates it, and throws if it is missing or has another size.
+    void attach(size_type n) {
+        if(path_.empty() || mapped_ || size_ != 0)
+            throw std::logic_error("only a prototype can attach to its file");
+        if(n == 0)
+            return;
+        void* ptr = detail::map_file(path_, backing_, n * sizeof(T), false);
+        data_     = static_cast<T*>(ptr);
+        mapped_   = true;
+        size_     = n;
+    }
+
+    /// Path of the backing file or segment, empty for in-memory buffers
+    const std::string& path() const noexcept { return path_; }
+
+    mapped_backing backing() const noexcept { return backing_; }
+
+    /// Remove the shared-memory segment `name`
+    static void unlink(const std::string& name) {
+        detail::unlink_shared(detail::shared_name(name));
+    }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+
+    reference operator[](size_type i) noexcept { return data_[i]; }
+    const_reference operator[](size_type i) const noexcept { return data_[i]; }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+  private:
+    void release() noexcept {
+        if(mapped_)
+            detail::unmap_file(data_, size_ * sizeof(T));
+        else
+            std::free(data_);
+        mapped_ = false;
+        data_   = nullptr;
+        size_   = 0;
+    }
+
+    std::string path_;
+    mapped_backing backing_ = mapped_backing::file;
+    bool mapped_            = false;
+    T* data_        = nullptr;
+    size_type size_ = 0;
+};
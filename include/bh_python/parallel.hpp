@@ -0,0 +1,54 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Splitting of loops over cells between threads. The calling thread takes the first
+// chunk, so a loop that is too small to split runs without starting any thread.
+// Chunks are multiples of a cache line of cells by default, so that threads never write
+// to the same cache line. The callable must not touch Python objects, it may run
+// without the GIL.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+/// Number of threads to use if the caller asks for 0
+inline unsigned default_threads() {
+    return (std::max)(std::thread::hardware_concurrency(), 1u);
+}
+
+/// Call fn(begin, end) on contiguous chunks of [0, n), using up to `threads` threads
+/// and at least `grain` items per thread. Chunks are multiples of `align` items.
+/// Exceptions are rethrown on the calling thread after every chunk is done.
+template <class F>
+void parallel_for(std::size_t n,
+                  unsigned threads,
+                  std::size_t grain,
+                  F&& fn,
+                  std::size_t align = 64) {
+    if(threads == 0)
+        threads = default_threads();
+    const auto most = n / (std::max)(grain, align);
+    threads = static_cast<unsigned>((std::min)(std::size_t{threads}, most));
+    if(threads < 2) {
+        fn(std::size_t{0}, n);
+        return;
+    }
+
+    const auto chunk = ((n + threads - 1) / threads + align - 1) / align * align;
+    std::vector<std::future<void>> rest;
+    for(auto begin = chunk; begin < n; begin += chunk) {
+        const auto end = (std::min)(begin + chunk, n);
+        rest.push_back(std::async(std::launch::async, [&fn, begin, end] {
+            fn(begin, end);
+        }));
+    }
+    fn(std::size_t{0}, (std::min)(chunk, n));
+    for(auto& f : rest)
+        f.get();
+}
@@ -0,0 +1,244 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Projections of dense histograms onto subsets of their axes. Several projections are
+// computed in one pass over the cells. Like in select.hpp, every projection has a table
+// per axis, which maps the bins of kept axes to offsets of its cells and the bins of
+// summed axes to 0. Rows along the first axis are added as contiguous blocks or summed
+// into a single cell, which the compiler can vectorize. Rows are split between threads
+// that add into cells of their own, which are summed in the order of the rows at the
+// end, so results do not depend on which thread finishes first. Cells are added in the
+// same order as bh::algorithm::project within each thread, so a projection on one
+// thread matches it exactly. The GIL is released meanwhile. Other storages are
+// projected with bh::algorithm::project.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <bh_python/parallel.hpp>
+#include <bh_python/select.hpp>
+
+#include <boost/histogram/algorithm/project.hpp>
+#include <boost/histogram/axis/traits.hpp>
+#include <boost/histogram/detail/axes.hpp>
+#include <boost/histogram/histogram.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/// Lists of axis numbers, one per projection
+using axis_lists = std::vector<std::vector<unsigned>>;
+
+namespace detail {
+
+/// The tables of a projection and how rows along the first axis are added
+struct projection {
+    enum class row_kind { contiguous, summed, mapped };
+
+    bin_map bins;
+    row_kind row;
+    std::size_t size;
+};
+
+/// Return the projection of the axes onto the axes at `keep`, in that order, and add
+/// the projected axes to `result_axes`
+template <class Axes>
+projection make_projection(const Axes& axes,
+                           const std::vector<unsigned>& keep,
+                           Axes& result_axes) {
+    const auto rank = bh::detail::axes_rank(axes);
+    if(keep.empty())
+        throw std::invalid_argument("at least one axis is required");
+
+    projection p;
+    p.bins.resize(rank);
+    for(std::size_t i = 0; i < rank; ++i)
+        p.bins[i].assign(static_cast<std::size_t>(bh::axis::traits::extent(axes[i])),
+                         0);
+
+    std::vector<bool> seen(rank, false);
+    std::size_t stride = 1;
+    for(auto i : keep) {
+        if(i >= rank)
+            throw std::invalid_argument("invalid axis index");
+        if(seen[i])
+            throw std::invalid_argument("indices must be unique");
+        seen[i]  = true;
+        auto& to = p.bins[i];
+        for(std::size_t b = 0; b < to.size(); ++b)
+            to[b] = b * stride;
+        stride *= to.size();
+        result_axes.push_back(axes[i]);
+    }
+    p.size = stride;
+
+    const auto& first = p.bins[0];
+    p.row             = seen[0] ? projection::row_kind::mapped
+                                : projection::row_kind::summed;
+    if(seen[0] && first.size() > 1 && first[1] == 1)
+        p.row = projection::row_kind::contiguous;
+    return p;
+}
+
+/// Add the rows [begin, end) of the source, numbered along all axes but the first, to
+/// the cells of each projection
+template <class T>
+void add_rows(const T* in,
+              const std::vector<T*>& outs,
+              const std::vector<projection>& ps,
+              std::size_t begin,
+              std::size_t end) {
+    const auto& extents = ps[0].bins;
+    const auto rank     = extents.size();
+    const auto row      = extents[0].size();
+
+    std::vector<std::size_t> index(rank, 0);
+    auto rest = begin;
+    for(std::size_t a = 1; a < rank; ++a) {
+        index[a] = rest % extents[a].size();
+        rest /= extents[a].size();
+    }
+
+    for(auto r = begin; r < end; ++r) {
+        const T* src = in + r * row;
+        for(std::size_t t = 0; t < ps.size(); ++t) {
+            const auto& p = ps[t];
+            T* out        = outs[t];
+            for(std::size_t a = 1; a < rank; ++a)
+                out += p.bins[a][index[a]];
+
+            switch(p.row) {
+            case projection::row_kind::contiguous:
+                for(std::size_t j = 0; j < row; ++j)
+                    out[j] += src[j];
+                break;
+            case projection::row_kind::summed: {
+                // a partial sum of the row would round differently than adding each
+                // cell, only integers are exact either way
+                if(std::is_integral<T>::value) {
+                    T total{};
+                    for(std::size_t j = 0; j < row; ++j)
+                        total += src[j];
+                    *out += total;
+                } else {
+                    for(std::size_t j = 0; j < row; ++j)
+                        *out += src[j];
+                }
+            } break;
+            case projection::row_kind::mapped: {
+                const auto& to = p.bins[0];
+                for(std::size_t j = 0; j < row; ++j)
+                    out[to[j]] += src[j];
+            } break;
+            }
+        }
+
+        for(std::size_t a = 1; a < rank && ++index[a] == extents[a].size(); ++a)
+            index[a] = 0;
+    }
+}
+
+template <class Histogram>
+std::vector<Histogram> project_histograms(std::false_type,
+                                          const Histogram& h,
+                                          const axis_lists& keep,
+                                          unsigned) {
+    std::vector<Histogram> result;
+    for(const auto& k : keep)
+        result.push_back(bh::algorithm::project(h, k));
+    return result;
+}
+
+template <class Histogram>
+std::vector<Histogram> project_histograms(std::true_type,
+                                          const Histogram& h,
+                                          const axis_lists& keep,
+                                          unsigned threads) {
+    using value_type = typename Histogram::value_type;
+    using axes_t     = typename Histogram::axes_type;
+
+    const auto& axes = bh::unsafe_access::axes(h);
+    std::vector<projection> ps;
+    std::vector<Histogram> result;
+    std::vector<value_type*> outs;
+    std::size_t total = 0;
+    for(const auto& k : keep) {
+        axes_t result_axes;
+        ps.push_back(make_projection(axes, k, result_axes));
+        result.emplace_back(std::move(result_axes), typename Histogram::storage_type());
+        total += ps.back().size;
+    }
+    for(auto& r : result)
+        outs.push_back(cells(bh::unsafe_access::storage(r)));
+    if(ps.empty())
+        return result;
+
+    const auto& storage = bh::unsafe_access::storage(h);
+    const value_type* in = cells(storage);
+    const auto row       = ps[0].bins[0].size();
+    const auto rows      = storage.size() / row;
+
+    py::gil_scoped_release release;
+
+    // every thread sums at least as many cells as it has private cells to merge
+    constexpr std::size_t block = 1 << 14;
+    const auto grain            = ((std::max)(block, total) + row - 1) / row;
+
+    // the first chunk adds into the result, the others into cells of their own
+    struct partial {
+        std::size_t begin;
+        std::vector<std::vector<value_type>> cells;
+    };
+    std::vector<partial> partials;
+    std::mutex keep_partial;
+    parallel_for(
+        rows,
+        threads,
+        grain,
+        [&](std::size_t begin, std::size_t end) {
+            if(begin == 0) {
+                add_rows(in, outs, ps, begin, end);
+                return;
+            }
+            partial mine{begin, std::vector<std::vector<value_type>>(ps.size())};
+            std::vector<value_type*> mine_outs;
+            for(std::size_t t = 0; t < ps.size(); ++t) {
+                mine.cells[t].resize(ps[t].size);
+                mine_outs.push_back(mine.cells[t].data());
+            }
+            add_rows(in, mine_outs, ps, begin, end);
+
+            std::lock_guard<std::mutex> lock(keep_partial);
+            partials.push_back(std::move(mine));
+        },
+        1);
+
+    std::sort(partials.begin(), partials.end(), [](const auto& a, const auto& b) {
+        return a.begin < b.begin;
+    });
+    for(const auto& p : partials)
+        for(std::size_t t = 0; t < ps.size(); ++t)
+            for(std::size_t c = 0; c < ps[t].size; ++c)
+                outs[t][c] += p.cells[t][c];
+    return result;
+}
+
+} // namespace detail
+
+/// Project onto each list of axes in one pass over the cells, see the top of this file.
+/// `threads` may be 0 for all cores.
+template <class Histogram>
+std::vector<Histogram> project_histograms(const Histogram& h,
+                                          const axis_lists& keep,
+                                          unsigned threads) {
+    return detail::project_histograms(
+        detail::is_dense_storage<typename Histogram::storage_type>{}, h, keep, threads);
+}
@@ -8,10 +8,14 @@
 #include <bh_python/pybind11.hpp>
 
 #include <bh_python/accumulators/ostream.hpp>
+#include <bh_python/arithmetic.hpp>
+#include <bh_python/arrow.hpp>
 #include <bh_python/axis.hpp>
 #include <bh_python/fill.hpp>
 #include <bh_python/histogram.hpp>
 #include <bh_python/make_pickle.hpp>
+#include <bh_python/project.hpp>
+#include <bh_python/select.hpp>
 #include <bh_python/storage.hpp>
 
 #include <boost/histogram/algorithm/empty.hpp>
@@ -30,6 +34,63 @@
 #include <tuple>
 #include <vector>
 
+/// Add a constructor from a numpy buffer and a read-only view for storages that can
+/// share memory with numpy arrays
+template <class Histogram>
+void register_from_buffer(std::true_type, py::class_<Histogram>& hist) {
+    hist.def_static("_from_buffer",
+                    &histogram_from_buffer<Histogram>,
+                    "axes"_a,
+                    "buffer"_a,
+                    "Make a histogram with the buffer (with flow bins) as storage")
+        .def("_shared_view",
+             &shared_view<Histogram>,
+             "Return a read-only view (with flow bins) of the current contents")
+        .def("_arrow_c_array",
+             &arrow_c_array<Histogram>,
+             "names"_a,
+             "Export the cells (with flow bins) as capsules of an Arrow struct array");
+}
+
+template <class Histogram>
+void register_from_buffer(std::false_type, py::class_<Histogram>&) {}
+
+/// Add incremental snapshots for storages that record which cells changed
+template <class Histogram>
+void register_changes(std::true_type, py::class_<Histogram>& hist) {
+    hist.def("_take_changes",
+             &take_changes<Histogram>,
+             "Return the cells changed since the previous call and their contents")
+        .def("_apply_changes",
+             &apply_changes<Histogram>,
+             "indices"_a,
+             "values"_a,
+             "Set the cells at the flat indices (with flow bins) to the values")
+        .def("_version",
+             &storage_version<Histogram>,
+             "Return a number that changes with the cells, or None if unknown");
+}
+
+template <class Histogram>
+void register_changes(std::false_type, py::class_<Histogram>&) {}
+
+/// Define the in-place operator with another histogram if `op` applies to this storage.
+/// The operator writes every cell, so the storage is prepared for that first.
+template <class Histogram, class Op>
+void def_inplace(std::true_type, py::class_<Histogram>& hist, const char* name, Op op) {
+    hist.def(
+        name,
+        [op](Histogram& self, const Histogram& other) -> Histogram& {
+            const auto guard = prepare_write(bh::unsafe_access::storage(self));
+            op(self, other);
+            return self;
+        },
+        py::is_operator());
+}
+
+template <class Histogram, class Op>
+void def_inplace(std::false_type, py::class_<Histogram>&, const char*, Op) {}
+
 template <class S>
 auto register_histogram(py::module& m, const char* name, const char* desc) {
     using histogram_t = bh::histogram<vector_axis_variant, S>;
@@ -39,12 +100,18 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
 
     hist.def(py::init<const vector_axis_variant&, S>(), "axes"_a, "storage"_a = S())
 
-        .def_buffer(
-            [](histogram_t& h) -> py::buffer_info { return make_buffer(h, false); })
+        .def_buffer([](histogram_t& h) -> py::buffer_info {
+            pin_storage(bh::unsafe_access::storage(h));
+            return make_buffer(h, false);
+        })
 
         .def("rank", &histogram_t::rank)
         .def("size", &histogram_t::size)
-        .def("reset", &histogram_t::reset)
+        .def("reset",
+             [](histogram_t& self) {
+                 const auto guard = prepare_write(bh::unsafe_access::storage(self));
+                 self.reset();
+             })
 
         .def("__copy__", [](const histogram_t& self) { return histogram_t(self); })
         .def("__deepcopy__",
@@ -58,7 +125,37 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
                  return a;
              })
 
-        .def(py::self += py::self)
+        .def("_empty_clone",
+             [](const histogram_t& self) {
+                 // copying the cells only to zero them would be wasted work
+                 return histogram_t(bh::unsafe_access::axes(self), S());
+             })
+
+        .def("_inplace_op",
+             &inplace_op<histogram_t>,
+             "op"_a,
+             "other"_a,
+             "Apply the in-place operator named op with a number or an array")
+
+        .def("_merge",
+             [](histogram_t& self, const histogram_t& other) { merge(self, other); },
+             "other"_a,
+             "Add a histogram with the same axes, releasing the GIL if possible")
+
+        .def_static(
+            "_sum",
+            [](const py::list& hists, unsigned threads) {
+                if(hists.size() == 0)
+                    throw py::value_error("No histograms to sum");
+                std::vector<const histogram_t*> ptrs;
+                ptrs.reserve(hists.size());
+                for(const auto& item : hists)
+                    ptrs.push_back(&py::cast<const histogram_t&>(item));
+                return sum_histograms(ptrs, threads);
+            },
+            "hists"_a,
+            "threads"_a = 0,
+            "Sum histograms with the same axes, adding cells on several threads")
 
         .def("__eq__",
              [](const histogram_t& self, const py::object& other) {
@@ -85,29 +182,27 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
 
         ;
 
-// Protection against an overzealous warning system
-// https://bugs.llvm.org/show_bug.cgi?id=43124
-#ifdef __clang__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wself-assign-overloaded"
-#endif
-    def_optionally(hist,
-                   bh::detail::has_operator_rdiv<histogram_t, histogram_t>{},
-                   py::self /= py::self);
-    def_optionally(hist,
-                   bh::detail::has_operator_rmul<histogram_t, histogram_t>{},
-                   py::self *= py::self);
-#ifdef __clang__
-#pragma GCC diagnostic pop
-#endif
+    def_inplace(std::true_type{}, hist, "__iadd__", [](auto& self, const auto& other) {
+        self += other;
+    });
+    def_inplace(bh::detail::has_operator_rdiv<histogram_t, histogram_t>{},
+                hist,
+                "__itruediv__",
+                [](auto& self, const auto& other) { self /= other; });
+    def_inplace(bh::detail::has_operator_rmul<histogram_t, histogram_t>{},
+                hist,
+                "__imul__",
+                [](auto& self, const auto& other) { self *= other; });
 
     hist.def(
             "to_numpy",
-            [](histogram_t& h, bool flow) {
+            [](py::object self, bool flow) {
+                auto& h = py::cast<histogram_t&>(self);
                 py::tuple tup(1 + h.rank());
 
-                // Add the histogram buffer as the first argument
-                unchecked_set(tup, 0, py::array(make_buffer(h, flow)));
+                // Add a view of the histogram buffer as the first argument
+                auto owner = make_view_owner(self, bh::unsafe_access::storage(h));
+                unchecked_set(tup, 0, py::array(make_buffer(h, flow), owner));
 
                 // Add the axis edges
                 h.for_each_axis([&tup, flow, i = 0u](const auto& ax) mutable {
@@ -121,8 +216,9 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
         .def(
             "view",
             [](py::object self, bool flow) {
-                auto& h = py::cast<histogram_t&>(self);
-                return py::array(make_buffer(h, flow), self);
+                auto& h    = py::cast<histogram_t&>(self);
+                auto owner = make_view_owner(self, bh::unsafe_access::storage(h));
+                return py::array(make_buffer(h, flow), owner);
             },
             "flow"_a = false)
 
@@ -161,7 +257,9 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
 
         .def("_at_set",
              [](histogram_t& self, const value_type& input, py::args& args) {
-                 auto int_args     = py::cast<std::vector<int>>(args);
+                 auto int_args = py::cast<std::vector<int>>(args);
+                 const auto guard
+                     = prepare_write(bh::unsafe_access::storage(self), false);
                  self.at(int_args) = input;
              })
 
@@ -185,21 +283,71 @@ auto register_histogram(py::module& m, const char* name, const char* desc) {
 
         .def("reduce",
              [](const histogram_t& self, py::args args) {
-                 return bh::algorithm::reduce(
-                     self, py::cast<std::vector<bh::algorithm::reduce_command>>(args));
+                 std::vector<bh::algorithm::reduce_command> commands;
+                 std::vector<rebin_edges_command> rebins;
+                 for(auto arg : args) {
+                     if(py::isinstance<rebin_edges_command>(arg))
+                         rebins.push_back(py::cast<rebin_edges_command>(arg));
+                     else
+                         commands.push_back(
+                             py::cast<bh::algorithm::reduce_command>(arg));
+                 }
+                 return reduce_histogram(self, commands, rebins);
              })
 
         .def("project",
              [](const histogram_t& self, py::args values) {
-                 return bh::algorithm::project(self,
-                                               py::cast<std::vector<unsigned>>(values));
+                 auto keep = py::cast<std::vector<unsigned>>(values);
+                 return std::move(project_histograms(self, {keep}, 0).front());
              })
 
+        .def("_project_many",
+             &project_histograms<histogram_t>,
+             "keep"_a,
+             "threads"_a = 0,
+             "Project onto each list of axes in a single pass over the cells")
+
+        .def("_select",
+             &select_bins<histogram_t>,
+             "slices"_a,
+             "picks"_a,
+             "pick_sets"_a,
+             "rebins"_a,
+             "sums"_a,
+             "Select the bins of each axis in one pass, see Histogram.__getitem__")
+
+        .def("_sliced_axes",
+             &sliced_axes<histogram_t>,
+             "slices"_a,
+             "Return the axes selected by the slices and the bins they keep")
+
         .def("fill", &fill<histogram_t>)
 
         .def(make_pickle<histogram_t>())
 
+        .def("_axes_state",
+             [](const histogram_t& self) {
+                 tuple_oarchive oa;
+                 oa << bh::unsafe_access::axes(self);
+                 return oa.finish();
+             })
+
+        .def_static(
+            "_from_state",
+            [](py::tuple axes_state, py::object buffer) {
+                typename histogram_t::axes_type axes;
+                tuple_iarchive ia{axes_state};
+                ia >> axes;
+                return histogram_from_buffer<histogram_t>(axes, std::move(buffer));
+            },
+            "axes_state"_a,
+            "buffer"_a,
+            "Make a histogram from saved axes and the view with flow bins")
+
         ;
 
+    register_from_buffer(is_adopting_storage<S>{}, hist);
+    register_changes(is_adopting_storage<S>{}, hist);
+
     return hist;
 }
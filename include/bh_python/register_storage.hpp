@@ -10,6 +10,10 @@
 #include <bh_python/make_pickle.hpp>
 #include <bh_python/storage.hpp>
 
+#include <stdexcept>
+#include <string>
+#include <utility>
+
 /// Add helpers common to all storage types
 template <class A>
 py::class_<A> register_storage(py::module& m, const char* name, const char* desc) {
@@ -70,3 +74,39 @@ register_storage(py::module& m, const char* name, const char* desc) {
 
     return storage;
 }
+
+/// Add helpers to the file-backed storage types
+template <class A>
+py::class_<A>
+register_mapped_storage(py::module& m, const char* name, const char* desc) {
+    using vector_t = mapped_vector<typename A::value_type>;
+
+    return register_storage<A>(m, name, desc)
+        .def(py::init([](std::string path) { return A(vector_t(std::move(path))); }),
+             "path"_a)
+        .def_property_readonly("path", [](const A& self) { return self.path(); });
+}
+
+/// Add helpers to the shared-memory storage types
+template <class A>
+py::class_<A>
+register_shared_storage(py::module& m, const char* name, const char* desc) {
+    using value_type = typename A::value_type;
+    using vector_t   = mapped_vector<value_type>;
+
+    return register_storage<A>(m, name, desc)
+        .def(py::init([](std::string path) {
+                 // other processes only see consistent counts with address-free atomics
+                 if(!value_type().is_lock_free())
+                     throw std::runtime_error(
+                         "Shared-memory storages require lock-free atomics");
+                 return A(vector_t(std::move(path), mapped_backing::shared_memory));
+             }),
+             "name"_a)
+        .def_property_readonly("path", [](const A& self) { return self.path(); })
+        .def_static(
+            "unlink",
+            [](const std::string& path) { vector_t::unlink(path); },
+            "name"_a,
+            "Remove the shared-memory segment, mapped histograms stay valid");
+}
@@ -0,0 +1,626 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Selection of a part of a histogram in a single pass over its cells, for indexing
+// with Histogram.__getitem__ and for reduce. Each axis is kept, possibly sliced and
+// rebinned like bh::algorithm::reduce does, or its bins are merged into the bins
+// between a list of its edges, or it is reduced to a list of picked categories, or it
+// is removed by picking a single bin or by summing over its bins. The categories that
+// are not picked are added to the overflow bin, if the axis has one, like the bins
+// outside of the edges.
+//
+// Every axis gets a table that maps each of its bins (with flow bins) to the offset of
+// a cell of the result, or to nothing if the bin is dropped. The cells of the source
+// are then added to the result with one table lookup per axis, without building any
+// intermediate histograms. Rows along the first axis are added as contiguous blocks
+// when the first axis is kept as it is. For dense storages, the bins of the last kept
+// axis are split between threads, so that every cell of the result is written by a
+// single thread; the GIL is released while cells are added.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <bh_python/axis.hpp>
+#include <bh_python/parallel.hpp>
+#include <bh_python/shared_vector.hpp>
+
+#include <boost/histogram/algorithm/reduce.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/traits.hpp>
+#include <boost/histogram/detail/axes.hpp>
+#include <boost/histogram/detail/static_if.hpp>
+#include <boost/histogram/histogram.hpp>
+#include <boost/histogram/storage_adaptor.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using index_list = std::vector<bh::axis::index_type>;
+
+/// Reduce a category axis to the categories at the indices, in that order
+struct pick_set_command {
+    unsigned iaxis;
+    index_list indices;
+};
+
+/// Merge the bins of an axis into the bins between the edges, each of which must be an
+/// edge of the axis. The axis becomes a variable axis.
+struct rebin_edges_command {
+    unsigned iaxis;
+    std::vector<double> edges;
+};
+
+namespace detail {
+
+using reduce_command = bh::algorithm::reduce_command;
+
+/// For each axis, the offset of the result cell of each bin (with flow bins)
+using bin_map = std::vector<std::vector<std::size_t>>;
+
+/// Marks a bin that does not contribute to the result
+constexpr std::size_t dropped_bin = static_cast<std::size_t>(-1);
+
+/// Storages whose cells may be written from several threads at once, as long as no two
+/// threads write to the same cell
+template <class S>
+struct is_dense_storage : std::false_type {};
+
+template <class T, class A>
+struct is_dense_storage<bh::storage_adaptor<shared_vector<T, A>>> : std::true_type {};
+
+/// The cells of a storage as indexed by add_selected, raw memory if possible
+template <class S>
+S& cells(S& storage) {
+    return storage;
+}
+
+template <class T, class A>
+T* cells(bh::storage_adaptor<shared_vector<T, A>>& storage) {
+    return storage.data();
+}
+
+template <class T, class A>
+const T* cells(const bh::storage_adaptor<shared_vector<T, A>>& storage) {
+    return storage.data();
+}
+
+/// Combine the commands to at most one per axis, like bh::algorithm::reduce does. A
+/// command with merge == 0 is unset.
+inline std::vector<reduce_command>
+normalize_commands(unsigned rank, const std::vector<reduce_command>& commands) {
+    using range_t = reduce_command::range_t;
+    std::vector<reduce_command> result(rank);
+    unsigned position = 0;
+    for(const auto& o : commands) {
+        const auto iaxis = o.iaxis == reduce_command::unset ? position : o.iaxis;
+        ++position;
+        if(iaxis >= rank)
+            throw std::invalid_argument("invalid axis index");
+        auto& to = result[iaxis];
+        if(to.merge == 0) {
+            to = o;
+        } else if(((o.range == range_t::none) == (to.range == range_t::none))
+                  || (to.merge > 1 && o.merge > 1)) {
+            throw std::invalid_argument("multiple conflicting reduce commands for axis "
+                                        + std::to_string(iaxis));
+        } else if(o.range != range_t::none) {
+            to.range = o.range;
+            to.begin = o.begin;
+            to.end   = o.end;
+            to.crop  = o.crop;
+        } else {
+            to.merge = o.merge;
+        }
+        to.iaxis = iaxis;
+    }
+    return result;
+}
+
+/// Turn a range of values into a range of indices, like bh::algorithm::reduce does
+template <class A>
+void index_range(const A& ax, reduce_command& o) {
+    bh::detail::static_if<bh::axis::traits::is_reducible<A>>(
+        [&o](const auto& ax) {
+            const auto end_value = o.end.value;
+            o.begin.index        = bh::axis::traits::index(ax, o.begin.value);
+            o.end.index          = bh::axis::traits::index(ax, end_value);
+            // the end is exclusive, unless the value is exactly on the upper edge
+            if(bh::axis::traits::value_as<double>(ax, o.end.index) != end_value)
+                ++o.end.index;
+        },
+        [&o](const auto&) {
+            throw std::invalid_argument("axis " + std::to_string(o.iaxis)
+                                        + " is not reducible");
+        },
+        ax);
+    o.range = reduce_command::range_t::indices;
+}
+
+/// Normalize the range of a slice like bh::algorithm::reduce and return the bin of the
+/// sliced axis (with flow bins) for each bin of the axis, see there
+template <class A>
+std::vector<std::size_t> slice_bins(const A& ax, reduce_command& o) {
+    using range_t = reduce_command::range_t;
+    using bh::axis::index_type;
+
+    if(o.range == range_t::values)
+        index_range(ax, o);
+
+    const auto opts     = bh::axis::traits::options(ax);
+    const auto size     = static_cast<index_type>(ax.size());
+    const index_type u  = (opts & bh::axis::option::underflow) ? 1 : 0;
+    o.is_ordered        = bh::axis::traits::ordered(ax);
+    o.use_underflow_bin = opts & bh::axis::option::underflow;
+    o.use_overflow_bin  = opts & bh::axis::option::overflow;
+    if(o.merge == 0)
+        o.merge = 1;
+    if(o.range == range_t::none) {
+        o.begin.index = 0;
+        o.end.index   = size;
+    } else {
+        if(o.crop) {
+            o.use_underflow_bin &= o.begin.index < 0;
+            o.use_overflow_bin &= o.end.index > size;
+        }
+        o.begin.index = (std::max)(o.begin.index, 0);
+        o.end.index   = (std::min)(o.end.index, size);
+    }
+    const auto merge = static_cast<index_type>(o.merge);
+    o.end.index -= (o.end.index - o.begin.index) % merge;
+
+    const auto end    = (o.end.index - o.begin.index) / merge;
+    const auto extent = bh::axis::traits::extent(ax);
+    std::vector<std::size_t> bins(static_cast<std::size_t>(extent));
+    for(index_type j = -u; j < extent - u; ++j) {
+        auto i   = j - o.begin.index;
+        auto& to = bins[static_cast<std::size_t>(j + u)];
+        if(o.is_ordered && i < 0) {
+            to = o.use_underflow_bin ? 0 : dropped_bin;
+            continue;
+        }
+        i = i >= 0 ? i / merge : o.end.index;
+        if(i >= end)
+            to = o.use_overflow_bin ? static_cast<std::size_t>(end + u) : dropped_bin;
+        else
+            to = static_cast<std::size_t>(i + u);
+    }
+    return bins;
+}
+
+/// Return the axis sliced as normalized by slice_bins
+template <class A>
+A sliced_axis(const A& ax, const reduce_command& o, unsigned iaxis) {
+    return bh::detail::static_if<bh::axis::traits::is_reducible<A>>(
+        [&o](const auto& ax) { return A(ax, o.begin.index, o.end.index, o.merge); },
+        [iaxis](const auto&) -> A {
+            throw std::invalid_argument("axis " + std::to_string(iaxis)
+                                        + " is not reducible");
+        },
+        ax);
+}
+
+/// Edges closer than this fraction of the mean bin width are the same
+constexpr double edge_tolerance = 1e-9;
+
+/// Return the positions of the edges among the edges of the axis, which must be
+/// ordered and numeric
+template <class A>
+index_list edge_positions(const A& ax,
+                          const std::vector<double>& edges,
+                          unsigned iaxis) {
+    return bh::detail::static_if<bh::axis::traits::is_reducible<A>>(
+        [&edges, iaxis](const auto& ax) {
+            if(!bh::axis::traits::ordered(ax))
+                throw std::invalid_argument("axis " + std::to_string(iaxis)
+                                            + " has no edges");
+            if(edges.size() < 2)
+                throw std::invalid_argument("at least two edges are required");
+
+            const auto size = ax.size();
+            std::vector<double> own(static_cast<std::size_t>(size) + 1);
+            for(bh::axis::index_type j = 0; j <= size; ++j)
+                own[static_cast<std::size_t>(j)]
+                    = bh::axis::traits::value_as<double>(ax, j);
+            const auto width = (own.back() - own.front()) / static_cast<double>(size);
+            const auto tolerance = edge_tolerance * width;
+
+            index_list positions;
+            for(auto edge : edges) {
+                // the nearest edge of the axis is at or right before the first
+                // that is not smaller
+                auto it = std::lower_bound(own.begin(), own.end(), edge);
+                if(it == own.end()
+                   || (it != own.begin() && edge - *(it - 1) < *it - edge))
+                    --it;
+                if(!(std::abs(*it - edge) <= tolerance))
+                    throw std::invalid_argument(
+                        "edge " + std::to_string(edge) + " is not an edge of axis "
+                        + std::to_string(iaxis));
+                const auto position
+                    = static_cast<bh::axis::index_type>(it - own.begin());
+                if(!positions.empty() && position <= positions.back())
+                    throw std::invalid_argument("edges must be strictly increasing");
+                positions.push_back(position);
+            }
+            return positions;
+        },
+        [iaxis](const auto&) -> index_list {
+            throw std::invalid_argument("axis " + std::to_string(iaxis)
+                                        + " is not reducible");
+        },
+        ax);
+}
+
+/// Add a variable axis with the edges of the axis at the positions and the same flow
+/// bins, see edge_positions
+template <class A, class Axes>
+void add_rebinned_axis(const A& ax, const index_list& positions, Axes& axes) {
+    bh::detail::static_if<bh::axis::traits::is_reducible<A>>(
+        [&positions, &axes](const auto& ax) {
+            std::vector<double> edges;
+            for(auto j : positions)
+                edges.push_back(bh::axis::traits::value_as<double>(ax, j));
+            const auto opts  = bh::axis::traits::options(ax);
+            const auto& m    = ax.metadata();
+            const bool under = opts & bh::axis::option::underflow;
+            const bool over  = opts & bh::axis::option::overflow;
+            if(under && over)
+                axes.emplace_back(axis::variable_uoflow(edges, m));
+            else if(under)
+                axes.emplace_back(axis::variable_uflow(edges, m));
+            else if(over)
+                axes.emplace_back(axis::variable_oflow(edges, m));
+            else
+                axes.emplace_back(axis::variable_none(edges, m));
+        },
+        [](const auto&) {},
+        ax);
+}
+
+/// Return the bin of the axis added by add_rebinned_axis (with flow bins) for each bin
+/// of the axis. Bins outside of the edges go to the flow bins, or are dropped if there
+/// are none.
+template <class A>
+std::vector<std::size_t> rebinned_bins(const A& ax, const index_list& positions) {
+    const auto opts        = bh::axis::traits::options(ax);
+    const std::size_t u    = (opts & bh::axis::option::underflow) ? 1 : 0;
+    const auto groups      = positions.size() - 1;
+    const std::size_t over = (opts & bh::axis::option::overflow) ? groups + u
+                                                                  : dropped_bin;
+
+    const auto extent = static_cast<std::size_t>(bh::axis::traits::extent(ax));
+    std::vector<std::size_t> bins(extent, over);
+    const auto first = static_cast<std::size_t>(positions.front()) + u;
+    std::fill(bins.begin(),
+              bins.begin() + static_cast<std::ptrdiff_t>(first),
+              u ? std::size_t{0} : dropped_bin);
+    for(std::size_t k = 0; k < groups; ++k) {
+        const auto end = static_cast<std::size_t>(positions[k + 1]);
+        for(auto j = static_cast<std::size_t>(positions[k]); j < end; ++j)
+            bins[j + u] = k + u;
+    }
+    return bins;
+}
+
+/// Return the edges of each axis, or nullptr if it is not rebinned onto edges
+inline std::vector<const std::vector<double>*>
+rebins_by_axis(unsigned rank, const std::vector<rebin_edges_command>& rebins) {
+    std::vector<const std::vector<double>*> result(rank, nullptr);
+    for(const auto& o : rebins) {
+        if(o.iaxis >= rank || result[o.iaxis] != nullptr)
+            throw std::invalid_argument(
+                "Expected at most one rebin onto edges per axis");
+        result[o.iaxis] = &o.edges;
+    }
+    return result;
+}
+
+/// Return the slice of each axis, unset slices have merge == 0
+inline std::vector<reduce_command>
+slices_by_axis(unsigned rank, const std::vector<reduce_command>& slices) {
+    std::vector<reduce_command> result(rank);
+    for(const auto& o : slices) {
+        if(o.iaxis >= rank || result[o.iaxis].merge > 0)
+            throw std::invalid_argument("Expected at most one slice per axis");
+        result[o.iaxis]       = o;
+        result[o.iaxis].merge = (std::max)(o.merge, 1u);
+    }
+    return result;
+}
+
+/// Return a category axis with only the categories at the indices
+template <class A>
+A picked_axis(const A&, const index_list&, unsigned iaxis) {
+    throw std::runtime_error("Axis " + std::to_string(iaxis)
+                             + " is not a categorical axis, cannot pick with list");
+}
+
+template <class... Ts>
+bh::axis::category<Ts...> picked_axis(const bh::axis::category<Ts...>& ax,
+                                      const index_list& indices,
+                                      unsigned) {
+    std::vector<typename bh::axis::category<Ts...>::value_type> values;
+    values.reserve(indices.size());
+    for(auto i : indices) {
+        if(i < 0 || i >= ax.size())
+            throw py::index_error("Picked index out of range");
+        values.push_back(ax.value(i));
+    }
+    return bh::axis::category<Ts...>(values, ax.metadata());
+}
+
+/// Return the bin of the picked axis (with flow bins) for each bin of the category
+/// axis. The other bins go to the overflow bin, or are dropped if there is none.
+template <class A>
+std::vector<std::size_t> picked_bins(const A& ax, const index_list& indices) {
+    const auto size   = static_cast<std::size_t>(ax.size());
+    const auto extent = static_cast<std::size_t>(bh::axis::traits::extent(ax));
+    const auto rest   = extent > size ? indices.size() : dropped_bin;
+    std::vector<std::size_t> bins(extent, rest);
+    for(std::size_t k = 0; k < indices.size(); ++k) {
+        auto& to = bins[static_cast<std::size_t>(indices[k])];
+        if(to != rest)
+            throw py::value_error("Each index may only be picked once");
+        to = k;
+    }
+    return bins;
+}
+
+/// Add every source cell to the result cell it maps to, visiting only the bins listed
+/// in `visit` for each axis, none of which may be dropped
+template <class In, class Out>
+void add_selected(In&& in, Out&& out, const bin_map& bins, const bin_map& visit) {
+    const auto rank = bins.size();
+    for(const auto& v : visit)
+        if(v.empty())
+            return;
+
+    std::vector<std::size_t> stride(rank, 1);
+    for(std::size_t a = 1; a < rank; ++a)
+        stride[a] = stride[a - 1] * bins[a - 1].size();
+
+    const auto& first = visit[0];
+    const auto& to    = bins[0];
+    bool contiguous   = first.size() == to.size();
+    for(std::size_t j = 0; contiguous && j < to.size(); ++j)
+        contiguous = to[j] == j;
+
+    // odometer over the visited bins of all axes but the first
+    std::vector<std::size_t> pos(rank, 0);
+    for(;;) {
+        std::size_t src = 0;
+        std::size_t dst = 0;
+        for(std::size_t a = 1; a < rank; ++a) {
+            const auto b = visit[a][pos[a]];
+            src += b * stride[a];
+            dst += bins[a][b];
+        }
+        if(contiguous) {
+            for(std::size_t j = 0; j < to.size(); ++j)
+                out[dst + j] += in[src + j];
+        } else {
+            for(auto j : first)
+                out[dst + to[j]] += in[src + j];
+        }
+
+        std::size_t a = 1;
+        for(; a < rank && ++pos[a] == visit[a].size(); ++a)
+            pos[a] = 0;
+        if(a == rank)
+            return;
+    }
+}
+
+/// Return the selection described by the arguments, see select_bins. There is one
+/// slice per axis, unset slices are ignored. `threads` may be 0 for all cores.
+template <class Histogram>
+Histogram select_cells(const Histogram& h,
+                       std::vector<reduce_command>& slices,
+                       const std::map<unsigned, bh::axis::index_type>& picks,
+                       const std::vector<const index_list*>& sets,
+                       const std::vector<const std::vector<double>*>& rebins,
+                       const std::set<unsigned>& sums,
+                       unsigned threads) {
+    using axes_t = typename Histogram::axes_type;
+
+    const auto& axes = bh::unsafe_access::axes(h);
+    const auto rank  = static_cast<unsigned>(bh::detail::axes_rank(axes));
+
+    axes_t result_axes;
+    bin_map bins(rank);
+    std::vector<bool> kept(rank, false);
+    unsigned iaxis = 0;
+    bh::detail::for_each_axis(axes, [&](const auto& ax) {
+        const auto i      = iaxis++;
+        const auto sliced = slices[i].merge > 0;
+        auto& to          = bins[i];
+        auto pick         = picks.find(i);
+        if(rebins[i] != nullptr && (sliced || sums.count(i) != 0))
+            throw std::invalid_argument("axis " + std::to_string(i)
+                                        + " cannot be rebinned onto edges and sliced");
+        if(pick != picks.end()) {
+            const auto extent = bh::axis::traits::extent(ax);
+            if(pick->second < 0 || pick->second >= extent)
+                throw py::index_error("histogram index is out of range");
+            to.assign(static_cast<std::size_t>(extent), dropped_bin);
+            to[static_cast<std::size_t>(pick->second)] = 0;
+        } else if(sets[i] != nullptr) {
+            result_axes.emplace_back(picked_axis(ax, *sets[i], i));
+            to      = picked_bins(ax, *sets[i]);
+            kept[i] = true;
+        } else if(sums.count(i) != 0) {
+            if(!sliced) {
+                to.assign(static_cast<std::size_t>(bh::axis::traits::extent(ax)), 0);
+            } else {
+                to = slice_bins(ax, slices[i]);
+                for(auto& b : to)
+                    if(b != dropped_bin)
+                        b = 0;
+            }
+        } else if(rebins[i] != nullptr) {
+            const auto positions = edge_positions(ax, *rebins[i], i);
+            add_rebinned_axis(ax, positions, result_axes);
+            to      = rebinned_bins(ax, positions);
+            kept[i] = true;
+        } else if(sliced) {
+            to = slice_bins(ax, slices[i]);
+            result_axes.emplace_back(sliced_axis(ax, slices[i], i));
+            kept[i] = true;
+        } else {
+            to.resize(static_cast<std::size_t>(bh::axis::traits::extent(ax)));
+            for(std::size_t b = 0; b < to.size(); ++b)
+                to[b] = b;
+            result_axes.emplace_back(ax);
+            kept[i] = true;
+        }
+    });
+
+    Histogram result(std::move(result_axes), typename Histogram::storage_type());
+
+    // turn the bins of kept axes into offsets of cells of the result
+    std::size_t stride = 1;
+    unsigned split     = rank;
+    std::size_t parts  = 1;
+    std::size_t width  = 1;
+    unsigned k         = 0;
+    bh::detail::for_each_axis(bh::unsafe_access::axes(result), [&](const auto& ax) {
+        while(!kept[k])
+            ++k;
+        for(auto& b : bins[k])
+            if(b != dropped_bin)
+                b *= stride;
+        split = k;
+        parts = static_cast<std::size_t>(bh::axis::traits::extent(ax));
+        width = stride;
+        stride *= parts;
+        ++k;
+    });
+
+    bin_map visit(rank);
+    for(unsigned a = 0; a < rank; ++a)
+        for(std::size_t b = 0; b < bins[a].size(); ++b)
+            if(bins[a][b] != dropped_bin)
+                visit[a].push_back(b);
+
+    const auto& in_storage = bh::unsafe_access::storage(h);
+    auto& out_storage      = bh::unsafe_access::storage(result);
+    auto&& in              = cells(in_storage);
+    auto&& out             = cells(out_storage);
+
+    py::gil_scoped_release release;
+
+    if(!is_dense_storage<typename Histogram::storage_type>::value || split == rank) {
+        add_selected(in, out, bins, visit);
+        return result;
+    }
+
+    // each thread fills the result cells of a range of bins of the last kept axis
+    constexpr std::size_t block = 1 << 14;
+    const auto per_part         = (std::max)(in_storage.size() / parts, std::size_t{1});
+    parallel_for(
+        parts,
+        threads,
+        (block + per_part - 1) / per_part,
+        [&](std::size_t begin, std::size_t end) {
+            auto mine = visit;
+            mine[split].clear();
+            for(auto b : visit[split]) {
+                const auto part = bins[split][b] / width;
+                if(begin <= part && part < end)
+                    mine[split].push_back(b);
+            }
+            add_selected(in, out, bins, mine);
+        },
+        1);
+    return result;
+}
+
+} // namespace detail
+
+/// Return the selection of the histogram described by the arguments, see the top of
+/// this file. The slices are applied to the kept axes and to the ranges of summed axes;
+/// picked bins are indices with flow bins, picked categories are indices without.
+/// If every axis is removed, the sum of the selected cells is returned.
+template <class Histogram>
+py::object select_bins(const Histogram& h,
+                       const std::vector<bh::algorithm::reduce_command>& slices,
+                       const std::map<unsigned, bh::axis::index_type>& picks,
+                       const std::vector<pick_set_command>& sets,
+                       const std::vector<rebin_edges_command>& rebins,
+                       const std::set<unsigned>& sums) {
+    const auto rank = static_cast<unsigned>(h.rank());
+
+    auto slice_of = detail::slices_by_axis(rank, slices);
+    std::vector<const index_list*> set_of(rank, nullptr);
+    for(const auto& o : sets) {
+        if(o.iaxis >= rank || set_of[o.iaxis] != nullptr)
+            throw std::invalid_argument("Expected at most one pick_set per axis");
+        set_of[o.iaxis] = &o.indices;
+    }
+
+    auto result = detail::select_cells(
+        h, slice_of, picks, set_of, detail::rebins_by_axis(rank, rebins), sums, 0);
+    if(result.rank() == 0)
+        return py::cast(bh::algorithm::sum(result, bh::coverage::all));
+    return py::cast(std::move(result));
+}
+
+/// Return the axes of the selection with only the slices, which must not rebin, without
+/// computing any cells. Each axis comes with the first and one past the last bin of the
+/// histogram that it keeps, without flow bins.
+template <class Histogram>
+py::list sliced_axes(const Histogram& h,
+                     const std::vector<bh::algorithm::reduce_command>& slices) {
+    const auto rank = static_cast<unsigned>(h.rank());
+    auto slice_of   = detail::slices_by_axis(rank, slices);
+
+    py::list result;
+    unsigned iaxis = 0;
+    bh::detail::for_each_axis(bh::unsafe_access::axes(h), [&](const auto& ax) {
+        const auto i = iaxis++;
+        auto& o      = slice_of[i];
+        if(o.merge == 0) {
+            result.append(py::make_tuple(py::cast(ax), 0, ax.size()));
+            return;
+        }
+        if(o.merge > 1)
+            throw std::invalid_argument("slices of axis " + std::to_string(i)
+                                        + " must not rebin");
+        detail::slice_bins(ax, o);
+        result.append(py::make_tuple(
+            py::cast(detail::sliced_axis(ax, o, i)), o.begin.index, o.end.index));
+    });
+    return result;
+}
+
+/// Reduce like bh::algorithm::reduce, and rebin onto edges; dense storages are reduced
+/// in a single pass on several threads without the GIL, see the top of this file
+template <class Histogram>
+Histogram reduce_histogram(const Histogram& h,
+                           const std::vector<bh::algorithm::reduce_command>& commands,
+                           const std::vector<rebin_edges_command>& rebins = {}) {
+    using dense = detail::is_dense_storage<typename Histogram::storage_type>;
+    if(!dense::value && rebins.empty())
+        return bh::algorithm::reduce(h, commands);
+
+    const auto rank = static_cast<unsigned>(h.rank());
+    auto slices     = detail::normalize_commands(rank, commands);
+    return detail::select_cells(h,
+                                slices,
+                                {},
+                                std::vector<const index_list*>(rank, nullptr),
+                                detail::rebins_by_axis(rank, rebins),
+                                {},
+                                default_threads());
+}
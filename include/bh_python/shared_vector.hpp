@@ -0,0 +1,388 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// A vector-like container for bh::storage_adaptor whose buffer is reference counted.
+// The buffer is either allocated by the container or adopted from another owner, like
+// a numpy array, which is then kept alive for as long as the buffer is in use. This
+// lets histograms be built on top of existing memory (pre-binned data, unpickled
+// arrays) without copying it.
+//
+// Copies share the buffer and the first write after copying makes it private
+// (copy-on-write), so copying a histogram costs as much as copying its axes. A buffer
+// that can be written from outside, because it was adopted from a user's array or is
+// exposed as a numpy view, is pinned and copied right away instead. A read-only buffer,
+// like an array unpickled from a read-only out-of-band buffer, is copied on the first
+// write.
+//
+// Element access does not check any of this, since it is what filling uses for every
+// cell. Every operation that writes cells calls prepare_write once before it starts,
+// which makes the buffer private and bumps a version number, so that results derived
+// from the cells can be cached until the next change.
+//
+// The container can also record which cells changed, for incremental snapshots. Writes
+// through operator[], which is what filling uses, set one bit per cell in a bitmap of
+// 64-cell blocks, so a snapshot skips clean blocks with one comparison. Operations that
+// write every cell say so in prepare_write and are recorded as such.
+//
+// Fills run without the GIL, so another thread may copy the histogram meanwhile. Writes
+// hold the lock returned by prepare_write until they are done, and copies take the same
+// lock, so a copy never sees a fill halfway. Atomic cells are meant to be filled by
+// several threads at once and are not locked.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <class T, class Allocator = std::allocator<T>>
+class shared_vector {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "shared_vector does not run destructors");
+
+    using traits = std::allocator_traits<Allocator>;
+
+  public:
+    using value_type      = T;
+    using allocator_type  = Allocator;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using iterator        = T*;
+    using const_iterator  = const T*;
+
+    /// Cells that are not trivially copyable, like atomics, are always copied right
+    /// away, so that concurrent fills never race to make a shared buffer private
+    static constexpr bool copy_on_write = std::is_trivially_copyable<T>::value;
+
+    /// Changes to atomic cells are not recorded per cell, since concurrent fills would
+    /// race on the bitmap
+    static constexpr bool records_cells = std::is_trivially_copyable<T>::value;
+
+    shared_vector() = default;
+    explicit shared_vector(const allocator_type&) {}
+
+    shared_vector(const shared_vector& other) {
+        const auto guard = other.lock();
+        share(other);
+    }
+
+    shared_vector(shared_vector&& other) noexcept { swap(other); }
+
+    shared_vector& operator=(const shared_vector& other) {
+        if(this != &other) {
+            shared_vector tmp(other);
+            replace(tmp);
+        }
+        return *this;
+    }
+
+    shared_vector& operator=(shared_vector&& other) noexcept {
+        shared_vector tmp(std::move(other));
+        replace(tmp);
+        return *this;
+    }
+
+    void swap(shared_vector& other) noexcept {
+        using std::swap;
+        swap(owner_, other.owner_);
+        swap(data_, other.data_);
+        swap(size_, other.size_);
+        swap(views_, other.views_);
+        swap(external_, other.external_);
+        swap(read_only_, other.read_only_);
+        swap(changes_, other.changes_);
+        swap(recording_, other.recording_);
+        swap(version_, other.version_);
+    }
+
+    void resize(size_type n) { resize(n, value_type()); }
+
+    void resize(size_type n, const_reference value) {
+        if(n == size_)
+            return;
+        shared_vector tmp;
+        tmp.allocate(n);
+        const auto kept = (std::min)(n, size_);
+        std::uninitialized_copy(data_, data_ + kept, tmp.data_);
+        // writing zeros into a zeroed buffer would touch all of its pages a second time
+        if(!preset(n, value))
+            std::uninitialized_fill(tmp.data_ + kept, tmp.data_ + n, value);
+        replace(tmp);
+    }
+
+    /// Use `n` cells at `ptr`, which stay valid while `owner` is alive, without
+    /// copying. Memory that is `external` may be written by others and is never
+    /// shared; memory that is not `writable` is copied on the first write.
+    void adopt(T* ptr,
+               size_type n,
+               std::shared_ptr<void> owner,
+               bool external,
+               bool writable) {
+        owner_     = std::move(owner);
+        data_      = ptr;
+        size_      = n;
+        views_     = nullptr;
+        external_  = external;
+        read_only_ = !writable;
+        recording_ = false;
+        touch();
+    }
+
+    /// Get ready for an operation that writes cells: make the buffer private and bump
+    /// the version. If not `every_cell`, the operation must write through operator[],
+    /// which records the cells for take_changes, otherwise all cells are reported. The
+    /// returned lock keeps copies out until the operation is done.
+    std::unique_lock<std::mutex> prepare_write(bool every_cell = true) {
+        auto guard = lock();
+        if(every_cell)
+            recording_ = false;
+        detach();
+        touch();
+        return guard;
+    }
+
+    /// Lock out writes and copies, see the top of this file. A thread that holds the
+    /// GIL releases it while it waits, since the writer may need the GIL to finish.
+    std::unique_lock<std::mutex> lock() const {
+        if(!copy_on_write)
+            return {};
+        std::unique_lock<std::mutex> guard(mutex_, std::try_to_lock);
+        if(!guard.owns_lock()) {
+            if(PyGILState_Check()) {
+                py::gil_scoped_release release;
+                guard.lock();
+            } else {
+                guard.lock();
+            }
+        }
+        return guard;
+    }
+
+    /// Make the buffer private and writable, copying it if it is shared or read-only
+    void detach() {
+        if(read_only_ || owner_.use_count() > 1) {
+            const std::shared_ptr<void> shared = owner_;
+            const T* const first               = data_;
+            allocate(size_);
+            std::uninitialized_copy(first, first + size_, data_);
+            read_only_ = false;
+        }
+    }
+
+    /// Keep the buffer private while the returned token is alive, which is needed
+    /// while it can be written through a numpy view
+    std::shared_ptr<void> pin() {
+        const auto guard = prepare_write();
+        if(!views_)
+            views_ = std::make_shared<char>();
+        return views_;
+    }
+
+    /// Keep the buffer private for good, for memory exported without a token
+    void pin_forever() {
+        const auto guard = prepare_write();
+        external_        = true;
+    }
+
+    bool pinned() const noexcept { return external_ || views_.use_count() > 1; }
+
+    /// Whether the version changes with every write, which is not the case while the
+    /// buffer can be written from outside or for atomic cells filled concurrently
+    bool knows_version() const noexcept { return records_cells && !pinned(); }
+
+    /// A number that grows with every prepare_write, see knows_version
+    std::uint64_t version() const noexcept { return version_; }
+
+    /// Put the indices of the cells changed since the previous call into `cells` and
+    /// start recording anew. Return true instead if every cell may have changed, which
+    /// is the case on the first call.
+    bool take_changes(std::vector<size_type>& cells) {
+        const auto guard = lock();
+        cells.clear();
+        const bool all = !recording_;
+        if(!all) {
+            for(size_type block = 0; block < changes_.size(); ++block) {
+                for(auto word = changes_[block]; word != 0; word &= word - 1) {
+                    size_type bit = 0;
+                    while(((word >> bit) & 1) == 0)
+                        ++bit;
+                    cells.push_back(block * 64 + bit);
+                }
+            }
+        }
+        if(records_cells) {
+            recording_ = false;
+            changes_.assign((size_ + 63) / 64, 0);
+            recording_ = true;
+        }
+        return all;
+    }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // Element access assumes that the buffer is private, see prepare_write. Writes
+    // through operator[] are recorded, but not those through data() or begin().
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+
+    reference operator[](size_type i) noexcept {
+        if(recording_)
+            changes_[i / 64] |= std::uint64_t{1} << (i % 64);
+        return data_[i];
+    }
+    const_reference operator[](size_type i) const noexcept { return data_[i]; }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+  private:
+    /// Share the buffer of `other`, or copy it if that cannot be done
+    void share(const shared_vector& other) {
+        if(copy_on_write && !other.pinned()) {
+            owner_     = other.owner_;
+            data_      = other.data_;
+            size_      = other.size_;
+            read_only_ = other.read_only_;
+        } else {
+            allocate(other.size_);
+            std::uninitialized_copy(other.data_, other.data_ + other.size_, data_);
+        }
+    }
+
+    // atomic cells are written concurrently, their version is never used
+    void touch() noexcept {
+        if(records_cells)
+            ++version_;
+    }
+
+    /// Take the contents of `other` as a new version of this one
+    void replace(shared_vector& other) noexcept {
+        const auto version = version_;
+        swap(other);
+        version_   = version;
+        recording_ = false;
+        touch();
+    }
+
+    template <class A = Allocator>
+    static auto zeroed(size_type n, int) -> decltype(A::allocates_zeros(n)) {
+        return A::allocates_zeros(n);
+    }
+
+    static bool zeroed(size_type, long) { return false; }
+
+    /// Whether a fresh buffer of `n` cells already holds `value` in every cell, because
+    /// the allocator zeroed it, see aligned_allocator::allocates_zeros
+    static bool preset(size_type n, const_reference value) {
+        if(!copy_on_write || !zeroed(n, 0))
+            return false;
+        const unsigned char zero[sizeof(T)] = {};
+        return std::memcmp(&value, zero, sizeof(T)) == 0;
+    }
+
+    void allocate(size_type n) {
+        if(n == 0) {
+            owner_.reset();
+            data_ = nullptr;
+            size_ = 0;
+            return;
+        }
+        allocator_type alloc;
+        T* ptr = traits::allocate(alloc, n);
+        // the deleter is called on ptr if the control block cannot be allocated
+        owner_ = std::shared_ptr<void>(ptr, [n](void* p) {
+            allocator_type a;
+            traits::deallocate(a, static_cast<T*>(p), n);
+        });
+        data_ = ptr;
+        size_ = n;
+    }
+
+    std::shared_ptr<void> owner_;
+    T* data_        = nullptr;
+    size_type size_ = 0;
+    std::shared_ptr<void> views_;
+    bool external_  = false;
+    bool read_only_ = false;
+    bool recording_ = false; ///< false if every cell may have changed
+    std::vector<std::uint64_t> changes_; ///< one bit per cell, see take_changes
+    std::uint64_t version_ = 0;
+    mutable std::mutex mutex_;
+};
+
+/// Keep a Python object alive from C++; it is released with the GIL held
+inline std::shared_ptr<void> make_python_owner(py::object obj) {
+    return std::shared_ptr<void>(obj.release().ptr(), [](void* ptr) {
+        py::gil_scoped_acquire gil;
+        Py_DECREF(static_cast<PyObject*>(ptr));
+    });
+}
+
+/// Whether the array can be used as the buffer of a shared_vector<T> without copying
+template <class T>
+bool can_adopt(const py::array& a) {
+    return reinterpret_cast<std::uintptr_t>(a.data()) % alignof(T) == 0;
+}
+
+/// Fill the vector from a flat numpy array of U, where each cell is made of
+/// sizeof(T) / sizeof(U) values. The memory of the array becomes the buffer if it can
+/// be used directly, otherwise it is copied. An array that does not own its memory,
+/// like one unpickled from an out-of-band buffer, is treated as external.
+template <class U, class T, class A>
+void load_buffer(shared_vector<T, A>& v, py::object obj) {
+    static_assert(sizeof(T) % sizeof(U) == 0, "cell must be made of whole values");
+    constexpr std::size_t values_per_cell = sizeof(T) / sizeof(U);
+
+    auto a = py::array_t<U, py::array::c_style | py::array::forcecast>::ensure(obj);
+    if(!a)
+        throw py::error_already_set();
+
+    const auto n = static_cast<std::size_t>(a.size()) / values_per_cell;
+    if(n > 0 && can_adopt<T>(a)) {
+        T* ptr              = reinterpret_cast<T*>(const_cast<U*>(a.data()));
+        const bool external = !a.owndata();
+        const bool writable = a.writeable();
+        v.adopt(ptr, n, make_python_owner(std::move(a)), external, writable);
+    } else {
+        v.resize(n);
+        std::copy(a.data(), a.data() + a.size(), reinterpret_cast<U*>(v.data()));
+    }
+}
+
+/// Return a read-only flat numpy array of U over the buffer, where each cell is made of
+/// sizeof(T) / sizeof(U) values. The array keeps a copy of the vector alive instead of
+/// copying the cells, so pickling with protocol 5 can hand the memory out of band.
+template <class U, class T, class A>
+py::array_t<U> share_buffer(const shared_vector<T, A>& v) {
+    static_assert(sizeof(T) % sizeof(U) == 0, "cell must be made of whole values");
+    using vector_t = shared_vector<T, A>;
+
+    if(v.empty())
+        return py::array_t<U>(0);
+
+    const auto* copy = new vector_t(v);
+    py::capsule owner(copy, [](void* ptr) { delete static_cast<vector_t*>(ptr); });
+    py::array_t<U> a(static_cast<py::ssize_t>(copy->size() * (sizeof(T) / sizeof(U))),
+                     reinterpret_cast<const U*>(copy->data()),
+                     owner);
+    a.attr("flags").attr("writeable") = false;
+    return a;
+}
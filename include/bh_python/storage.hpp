@@ -10,6 +10,10 @@
 #include <bh_python/accumulators/mean.hpp>
 #include <bh_python/accumulators/weighted_mean.hpp>
 #include <bh_python/accumulators/weighted_sum.hpp>
+#include <bh_python/aligned_allocator.hpp>
+#include <bh_python/cell_encoding.hpp>
+#include <bh_python/mapped_vector.hpp>
+#include <bh_python/shared_vector.hpp>
 
 #include <boost/histogram/accumulators/thread_safe.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
@@ -17,18 +21,32 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <string>
 #include <type_traits>
 
 namespace storage {
 
+// Dense storages allocate with the process-wide policy, see aligned_allocator.hpp, and
+// can adopt memory owned by numpy arrays, see shared_vector.hpp
+template <class T>
+using dense = bh::storage_adaptor<shared_vector<T, aligned_allocator<T>>>;
+
 // Names match Python names
-using int64         = bh::dense_storage<uint64_t>;
-using atomic_int64  = bh::dense_storage<bh::accumulators::thread_safe<uint64_t>>;
-using double_       = bh::dense_storage<double>;
+using int64         = dense<uint64_t>;
+using atomic_int64  = dense<bh::accumulators::thread_safe<uint64_t>>;
+using double_       = dense<double>;
 using unlimited     = bh::unlimited_storage<>;
-using weight        = bh::dense_storage<accumulators::weighted_sum<double>>;
-using mean          = bh::dense_storage<accumulators::mean<double>>;
-using weighted_mean = bh::dense_storage<accumulators::weighted_mean<double>>;
+using weight        = dense<accumulators::weighted_sum<double>>;
+using mean          = dense<accumulators::mean<double>>;
+using weighted_mean = dense<accumulators::weighted_mean<double>>;
+
+// File-backed storages, see mapped_vector.hpp
+using mapped_int64  = bh::storage_adaptor<mapped_vector<uint64_t>>;
+using mapped_double = bh::storage_adaptor<mapped_vector<double>>;
+using mapped_weight
+    = bh::storage_adaptor<mapped_vector<accumulators::weighted_sum<double>>>;
+using shared_atomic_int64
+    = bh::storage_adaptor<mapped_vector<bh::accumulators::thread_safe<uint64_t>>>;
 
 // Allow repr to show python name
 template <class S>
@@ -71,6 +89,73 @@ inline const char* name<weighted_mean>() {
     return "weighted_mean";
 }
 
+template <>
+inline const char* name<mapped_int64>() {
+    return "mapped_int64";
+}
+
+template <>
+inline const char* name<mapped_double>() {
+    return "mapped_double";
+}
+
+template <>
+inline const char* name<mapped_weight>() {
+    return "mapped_weight";
+}
+
+template <>
+inline const char* name<shared_atomic_int64>() {
+    return "shared_atomic_int64";
+}
+
+namespace detail {
+/// Scalar type used to store a cell as a flat numpy array
+template <class T>
+struct flat_type {
+    using type = T;
+};
+
+template <class T>
+struct flat_type<accumulators::weighted_sum<T>> {
+    using type = T;
+};
+
+/// Save where a mapped storage lives and return whether the cells live there too.
+/// Shared-memory segments are reattached by name when loading, so a pickled histogram
+/// sent to another process fills the same memory. A filled file-backed storage is
+/// loaded into memory like a copy, so two histograms never share a file by accident.
+template <class Archive, class T>
+bool save_mapped_header(Archive& ar, const mapped_vector<T>& v) {
+    const bool shared = v.backing() == mapped_backing::shared_memory;
+    const std::string path = shared || v.size() == 0 ? v.path() : std::string{};
+    ar << path;
+    ar << shared;
+    ar << v.size();
+    return !path.empty();
+}
+
+template <class Archive, class T>
+bool load_mapped_header(Archive& ar, mapped_vector<T>& v) {
+    std::string path;
+    bool shared;
+    std::size_t size;
+    ar >> path;
+    ar >> shared;
+    ar >> size;
+    mapped_vector<T> tmp(std::move(path),
+                         shared ? mapped_backing::shared_memory : mapped_backing::file);
+    // a shared-memory segment must still exist, recreating it would silently detach
+    // this histogram from the processes that fill the original
+    if(shared && size > 0)
+        tmp.attach(size);
+    else
+        tmp.resize(size);
+    v.swap(tmp);
+    return !v.path().empty();
+}
+} // namespace detail
+
 } // namespace storage
 
 // It is very important that storages with accumulators have specialized serialization.
@@ -96,84 +181,103 @@ void load(Archive& ar, storage::atomic_int64& s, unsigned /* version */) {
 }
 
 template <class Archive>
-void save(Archive& ar,
-          const bh::dense_storage<accumulators::weighted_sum<double>>& s,
-          unsigned /* version */) {
+void save(Archive& ar, const storage::weight& s, unsigned /* version */) {
     using T = accumulators::weighted_sum<double>;
     static_assert(std::is_standard_layout<T>::value
                       && std::is_trivially_copyable<T>::value
                       && sizeof(T) == 2 * sizeof(double),
                   "weighted_sum cannot be fast serialized");
-    // view storage buffer as flat numpy array
-    py::array_t<double> a(static_cast<py::ssize_t>(s.size()) * 2,
-                          reinterpret_cast<const double*>(s.data()));
-    ar << a;
+    // view storage buffer as flat numpy array, or save it sparsely if mostly empty
+    save_cells<double>(ar, s);
 }
 
 template <class Archive>
-void load(Archive& ar,
-          bh::dense_storage<accumulators::weighted_sum<double>>& s,
-          unsigned /* version */) {
-    // data is stored as flat numpy array
-    py::array_t<double> a;
-    ar >> a;
-    s.resize(static_cast<std::size_t>(a.size() / 2));
-    // sadly we cannot move the memory from the numpy array into the vector
-    std::copy(a.data(), a.data() + a.size(), reinterpret_cast<double*>(s.data()));
+void load(Archive& ar, storage::weight& s, unsigned /* version */) {
+    // a dense flat numpy array becomes the buffer if possible
+    load_cells<double>(ar, s);
 }
 
 template <class Archive>
-void save(Archive& ar,
-          const bh::dense_storage<accumulators::mean<double>>& s,
-          unsigned /* version */) {
+void save(Archive& ar, const storage::mean& s, unsigned /* version */) {
     using T = accumulators::mean<double>;
     static_assert(std::is_standard_layout<T>::value
                       && std::is_trivially_copyable<T>::value
                       && sizeof(T) == 3 * sizeof(double),
                   "mean cannot be fast serialized");
-    // view storage buffer as flat numpy array
-    py::array_t<double> a(static_cast<py::ssize_t>(s.size()) * 3,
-                          reinterpret_cast<const double*>(s.data()));
-    ar << a;
+    // view storage buffer as flat numpy array, or save it sparsely if mostly empty
+    save_cells<double>(ar, s);
 }
 
 template <class Archive>
-void load(Archive& ar,
-          bh::dense_storage<accumulators::mean<double>>& s,
-          unsigned /* version */) {
-    // data is stored as flat numpy array
-    py::array_t<double> a;
-    ar >> a;
-    s.resize(static_cast<std::size_t>(a.size() / 3));
-    // sadly we cannot move the memory from the numpy array into the vector
-    std::copy(a.data(), a.data() + a.size(), reinterpret_cast<double*>(s.data()));
+void load(Archive& ar, storage::mean& s, unsigned /* version */) {
+    // a dense flat numpy array becomes the buffer if possible
+    load_cells<double>(ar, s);
 }
 
 template <class Archive>
-void save(Archive& ar,
-          const bh::dense_storage<accumulators::weighted_mean<double>>& s,
-          unsigned /* version */) {
+void save(Archive& ar, const storage::weighted_mean& s, unsigned /* version */) {
     using T = accumulators::weighted_mean<double>;
     static_assert(std::is_standard_layout<T>::value
                       && std::is_trivially_copyable<T>::value
                       && sizeof(T) == 4 * sizeof(double),
                   "weighted_mean cannot be fast serialized");
-    // view storage buffer as flat numpy array
-    py::array_t<double> a(static_cast<py::ssize_t>(s.size()) * 4,
-                          reinterpret_cast<const double*>(s.data()));
-    ar << a;
+    // view storage buffer as flat numpy array, or save it sparsely if mostly empty
+    save_cells<double>(ar, s);
 }
 
 template <class Archive>
+void load(Archive& ar, storage::weighted_mean& s, unsigned /* version */) {
+    // a dense flat numpy array becomes the buffer if possible
+    load_cells<double>(ar, s);
+}
+
+template <class Archive, class T>
+void save(Archive& ar,
+          const bh::storage_adaptor<mapped_vector<T>>& s,
+          unsigned /* version */) {
+    using V = typename storage::detail::flat_type<T>::type;
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(V) == 0,
+                  "mapped storage cannot be fast serialized");
+    constexpr std::size_t n = sizeof(T) / sizeof(V);
+    const bool attached     = storage::detail::save_mapped_header(ar, s);
+    py::array_t<V> a(static_cast<py::ssize_t>(attached ? 0 : s.size() * n),
+                     reinterpret_cast<const V*>(s.data()));
+    ar << a;
+}
+
+template <class Archive, class T>
 void load(Archive& ar,
-          bh::dense_storage<accumulators::weighted_mean<double>>& s,
+          bh::storage_adaptor<mapped_vector<T>>& s,
           unsigned /* version */) {
-    // data is stored as flat numpy array
-    py::array_t<double> a;
+    using V             = typename storage::detail::flat_type<T>::type;
+    const bool attached = storage::detail::load_mapped_header(ar, s);
+    py::array_t<V> a;
     ar >> a;
-    s.resize(static_cast<std::size_t>(a.size() / 4));
-    // sadly we cannot move the memory from the numpy array into the vector
-    std::copy(a.data(), a.data() + a.size(), reinterpret_cast<double*>(s.data()));
+    if(!attached)
+        std::copy(a.data(), a.data() + a.size(), reinterpret_cast<V*>(s.data()));
+}
+
+template <class Archive, class T>
+void save(Archive& ar,
+          const bh::storage_adaptor<mapped_vector<bh::accumulators::thread_safe<T>>>& s,
+          unsigned /* version */) {
+    // atomics cannot be viewed as a numpy array, see atomic_int64
+    const bool attached = storage::detail::save_mapped_header(ar, s);
+    py::array_t<std::int64_t> a(static_cast<py::ssize_t>(attached ? 0 : s.size()));
+    if(!attached)
+        std::copy(s.begin(), s.end(), a.mutable_data());
+    ar << a;
+}
+
+template <class Archive, class T>
+void load(Archive& ar,
+          bh::storage_adaptor<mapped_vector<bh::accumulators::thread_safe<T>>>& s,
+          unsigned /* version */) {
+    const bool attached = storage::detail::load_mapped_header(ar, s);
+    py::array_t<std::int64_t> a;
+    ar >> a;
+    if(!attached)
+        std::copy(a.data(), a.data() + a.size(), s.begin());
 }
 
 namespace pybind11 {
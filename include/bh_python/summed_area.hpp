@@ -0,0 +1,275 @@
+// Copyright 2021 Henry Schreiner and Hans Dembinski
+//
+// Distributed under the 3-Clause BSD License.  See accompanying
+// file LICENSE or https://github.com/scikit-hep/boost-histogram for details.
+
+// Summed-area tables, for sums of cells over boxes of bins in a time that does not
+// depend on the size of the box. The table of an array has one more entry along each
+// axis: the entry at (i_0, ..., i_n) is the sum of the array over the box
+// [0, i_0) x ... x [0, i_n), so the sum over any box follows from the entries at its
+// 2^rank corners. Arrays and tables are in Fortran order, like the views of histograms.
+//
+// The table is built one axis at a time. Along the first axis every row is summed as it
+// is copied, along the others whole planes are added to the next one, which the
+// compiler can vectorize. Both steps and the sums over boxes are split between threads
+// and run without the GIL. Unsigned integers wrap around, so integer tables give exact
+// sums as long as the sums themselves fit. Floating-point entries are rounded relative
+// to the sum of everything below them, so the sum over a small box next to large bins
+// can only be as precise as that; the corners are added with compensation so that at
+// least combining them loses nothing more.
+
+#pragma once
+
+#include <bh_python/pybind11.hpp>
+
+#include <bh_python/parallel.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+template <class T>
+using fortran_array = py::array_t<T, py::array::f_style | py::array::forcecast>;
+
+/// Boxes, one per row, given by a bin index per axis
+using box_array = py::array_t<py::ssize_t, py::array::c_style | py::array::forcecast>;
+
+namespace detail {
+
+/// Every thread does at least this much work
+constexpr std::size_t summed_area_block = 1 << 14;
+
+/// Running sum of the corners of a box, integers are exact
+template <class T, bool = std::is_floating_point<T>::value>
+class corner_sum {
+  public:
+    void add(T x) { sum_ += x; }
+    void subtract(T x) { sum_ -= x; }
+    T value() const { return sum_; }
+
+  private:
+    T sum_{};
+};
+
+/// Floating-point corners are large next to the sum over a small box, so the rounding
+/// error of every step is kept and added at the end (Neumaier's summation)
+template <class T>
+class corner_sum<T, true> {
+  public:
+    void add(T x) {
+        const T s = sum_ + x;
+        if(std::abs(sum_) >= std::abs(x))
+            error_ += (sum_ - s) + x;
+        else
+            error_ += (x - s) + sum_;
+        sum_ = s;
+    }
+    void subtract(T x) { add(-x); }
+    T value() const { return sum_ + error_; }
+
+  private:
+    T sum_{};
+    T error_{};
+};
+
+/// Fill the rows [begin, end) of the table, numbered along all axes but the first, with
+/// the running sums of the rows of the array
+template <class T>
+void sum_rows(const T* in,
+              T* out,
+              const std::vector<std::size_t>& extents,
+              std::size_t begin,
+              std::size_t end) {
+    const auto rank = extents.size();
+    const auto row  = extents[0];
+
+    std::vector<std::size_t> index(rank, 0);
+    auto rest = begin;
+    for(std::size_t a = 1; a < rank; ++a) {
+        index[a] = rest % extents[a];
+        rest /= extents[a];
+    }
+
+    for(auto r = begin; r < end; ++r) {
+        T* dst = out + r * row;
+
+        // the first entry along every axis is the sum over an empty box
+        bool edge          = false;
+        std::size_t src    = 0;
+        std::size_t stride = 1;
+        for(std::size_t a = 1; a < rank; ++a) {
+            if(index[a] == 0) {
+                edge = true;
+                break;
+            }
+            src += (index[a] - 1) * stride;
+            stride *= extents[a] - 1;
+        }
+
+        dst[0] = T{};
+        if(edge) {
+            std::fill(dst + 1, dst + row, T{});
+        } else {
+            const T* s = in + src * (row - 1);
+            for(std::size_t j = 1; j < row; ++j)
+                dst[j] = dst[j - 1] + s[j - 1];
+        }
+
+        for(std::size_t a = 1; a < rank && ++index[a] == extents[a]; ++a)
+            index[a] = 0;
+    }
+}
+
+/// Add each plane along an axis to the next one, for the cells [begin, end) of a plane.
+/// Cells are numbered along the axes before the one summed over, of `inner` cells, then
+/// along the axes after it.
+template <class T>
+void sum_planes(T* out,
+                std::size_t inner,
+                std::size_t extent,
+                std::size_t begin,
+                std::size_t end) {
+    while(begin < end) {
+        const auto first = begin % inner;
+        const auto last  = (std::min)(inner, first + (end - begin));
+        T* base          = out + begin / inner * inner * extent;
+        for(std::size_t j = 1; j < extent; ++j) {
+            T* plane       = base + j * inner;
+            const T* prior = plane - inner;
+            for(auto i = first; i < last; ++i)
+                plane[i] += prior[i];
+        }
+        begin += last - first;
+    }
+}
+
+} // namespace detail
+
+/// Return the summed-area table of an array, see the top of this file. `threads` may be
+/// 0 for all cores.
+template <class T>
+fortran_array<T> summed_area_table(const fortran_array<T>& a, unsigned threads) {
+    const auto rank = static_cast<std::size_t>(a.ndim());
+    if(rank == 0)
+        throw std::invalid_argument("array must have at least one axis");
+
+    std::vector<std::size_t> extents(rank);
+    std::vector<py::ssize_t> shape(rank);
+    std::size_t size = 1;
+    for(std::size_t k = 0; k < rank; ++k) {
+        shape[k]   = a.shape(static_cast<py::ssize_t>(k)) + 1;
+        extents[k] = static_cast<std::size_t>(shape[k]);
+        size *= extents[k];
+    }
+
+    fortran_array<T> table(shape);
+    const T* in = a.data();
+    T* out      = table.mutable_data();
+
+    py::gil_scoped_release release;
+
+    const auto rows = size / extents[0];
+    parallel_for(
+        rows,
+        threads,
+        detail::summed_area_block / extents[0] + 1,
+        [&](std::size_t begin, std::size_t end) {
+            detail::sum_rows(in, out, extents, begin, end);
+        },
+        1);
+
+    std::size_t inner = extents[0];
+    for(std::size_t k = 1; k < rank; ++k) {
+        const auto extent = extents[k];
+        parallel_for(size / extent,
+                     threads,
+                     detail::summed_area_block / extent + 1,
+                     [&](std::size_t begin, std::size_t end) {
+                         detail::sum_planes(out, inner, extent, begin, end);
+                     });
+        inner *= extent;
+    }
+    return table;
+}
+
+/// Return the sum over each box [lower, upper) of the array with the given summed-area
+/// table. Bounds are clamped to the array, empty boxes sum to zero.
+template <class T>
+py::array_t<T> box_sums(const fortran_array<T>& table,
+                        const box_array& lower,
+                        const box_array& upper,
+                        unsigned threads) {
+    const auto rank = static_cast<std::size_t>(table.ndim());
+    if(lower.ndim() != 2 || upper.ndim() != 2 || lower.shape(0) != upper.shape(0)
+       || static_cast<std::size_t>(lower.shape(1)) != rank
+       || static_cast<std::size_t>(upper.shape(1)) != rank)
+        throw std::invalid_argument("boxes must have one bound per axis of the table");
+    if(rank >= 8 * sizeof(std::size_t))
+        throw std::invalid_argument("table has too many axes");
+
+    std::vector<py::ssize_t> extents(rank);
+    std::vector<std::size_t> strides(rank);
+    std::size_t stride = 1;
+    for(std::size_t k = 0; k < rank; ++k) {
+        extents[k] = table.shape(static_cast<py::ssize_t>(k));
+        strides[k] = stride;
+        stride *= static_cast<std::size_t>(extents[k]);
+    }
+
+    const auto n = static_cast<std::size_t>(lower.shape(0));
+    py::array_t<T> result(static_cast<py::ssize_t>(n));
+    const T* t            = table.data();
+    const py::ssize_t* lo = lower.data();
+    const py::ssize_t* hi = upper.data();
+    T* out                = result.mutable_data();
+
+    py::gil_scoped_release release;
+
+    const std::size_t corners = std::size_t{1} << rank;
+    const auto clamp          = [](py::ssize_t i, py::ssize_t top) {
+        return (std::min)((std::max)(i, py::ssize_t{0}), top);
+    };
+    parallel_for(
+        n,
+        threads,
+        detail::summed_area_block / corners + 1,
+        [&](std::size_t begin, std::size_t end) {
+            std::vector<std::size_t> first(rank), last(rank);
+            for(auto q = begin; q < end; ++q) {
+                bool empty = false;
+                for(std::size_t k = 0; k < rank; ++k) {
+                    const auto l = clamp(lo[q * rank + k], extents[k] - 1);
+                    const auto h = clamp(hi[q * rank + k], extents[k] - 1);
+                    empty        = empty || l >= h;
+                    first[k] = static_cast<std::size_t>(l) * strides[k];
+                    last[k]  = static_cast<std::size_t>(h) * strides[k];
+                }
+                if(empty) {
+                    out[q] = T{};
+                    continue;
+                }
+
+                // corners with an even number of lower bounds are added, the others
+                // subtracted
+                detail::corner_sum<T> sum;
+                for(std::size_t c = 0; c < corners; ++c) {
+                    std::size_t offset = 0;
+                    std::size_t lowers = 0;
+                    for(std::size_t k = 0; k < rank; ++k) {
+                        const bool upper_bound = (c >> k) & 1;
+                        offset += upper_bound ? last[k] : first[k];
+                        lowers += upper_bound ? 0 : 1;
+                    }
+                    if(lowers % 2 == 1)
+                        sum.subtract(t[offset]);
+                    else
+                        sum.add(t[offset]);
+                }
+                out[q] = sum.value();
+            }
+        });
+    return result;
+}
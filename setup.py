@@ -44,6 +44,7 @@ ext_modules = [
         include_dirs=INCLUDE_DIRS,
         cxx_std=cxx_std,
         extra_compile_args=["/d2FH4-"] if sys.platform.startswith("win32") else [],
+        libraries=["rt"] if sys.platform.startswith("linux") else [],
     )
 ]
 
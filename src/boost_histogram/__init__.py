@@ -1,6 +1,7 @@
 from . import accumulators, axis, numpy, storage
 from ._internal.enum import Kind
-from ._internal.hist import Histogram, IndexingExpr
+from ._internal.hist import Histogram, HistogramDelta, IndexingExpr
+from ._internal.merge import merge_files, sum_histograms
 from .tag import loc, overflow, rebin, sum, underflow
 from .version import version as __version__
 
@@ -20,6 +21,7 @@ except ImportError as err:
 
 __all__ = (
     "Histogram",
+    "HistogramDelta",
     "IndexingExpr",
     "Kind",
     "axis",
@@ -27,8 +29,10 @@ __all__ = (
     "accumulators",
     "numpy",
     "loc",
+    "merge_files",
     "rebin",
     "sum",
+    "sum_histograms",
     "underflow",
     "overflow",
     "__version__",
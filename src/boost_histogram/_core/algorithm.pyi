@@ -1,9 +1,17 @@
 import enum
 import typing
 
+import numpy as np
+
 class reduce_command:
     def __repr__(self) -> str: ...
 
+class pick_set_command:
+    def __repr__(self) -> str: ...
+
+class rebin_edges_command:
+    def __repr__(self) -> str: ...
+
 class slice_mode(enum.Enum):
     shrink = enum.auto()
     crop = enum.auto()
@@ -44,3 +52,9 @@ def crop(lower: float, upper: float) -> reduce_command: ...
 def slice(iaxis: int, begin: int, end: int, mode: slice_mode) -> reduce_command: ...
 @typing.overload
 def slice(begin: int, end: int, mode: slice_mode) -> reduce_command: ...
+def pick_set(iaxis: int, indices: typing.List[int]) -> pick_set_command: ...
+def rebin_edges(iaxis: int, edges: typing.List[float]) -> rebin_edges_command: ...
+def summed_area_table(array: np.ndarray, threads: int = ...) -> np.ndarray: ...
+def box_sums(
+    table: np.ndarray, lower: np.ndarray, upper: np.ndarray, threads: int = ...
+) -> np.ndarray: ...
@@ -1,4 +1,15 @@
-from typing import Any, ClassVar, Iterable, Iterator, Tuple, Type, TypeVar
+from typing import (
+    Any,
+    ClassVar,
+    Dict,
+    Iterable,
+    Iterator,
+    List,
+    Set,
+    Tuple,
+    Type,
+    TypeVar,
+)
 
 import numpy as np
 from numpy.typing import ArrayLike
@@ -21,7 +32,12 @@ class _BaseHistogram:
     def __repr__(self) -> str: ...
     def __copy__(self: T) -> T: ...
     def __deepcopy__(self: T, memo: Any) -> T: ...
+    def _empty_clone(self: T) -> T: ...
     def __iadd__(self: T, other: _BaseHistogram) -> T: ...
+    def _merge(self, other: _BaseHistogram) -> None: ...
+    def _inplace_op(self, op: str, other: ArrayLike) -> None: ...
+    @classmethod
+    def _sum(cls: Type[T], hists: List[T], threads: int = ...) -> T: ...
     def to_numpy(self, flow: bool = ...) -> Tuple[np.ndarray, ...]: ...
     def view(self, flow: bool = ...) -> np.ndarray: ...
     def axis(self, i: int = ...) -> axis._BaseAxis: ...
@@ -29,8 +45,36 @@ class _BaseHistogram:
     def empty(self, flow: bool = ...) -> bool: ...
     def reduce(self: T, *args: Any) -> T: ...
     def project(self: T, *args: int) -> T: ...
+    def _project_many(
+        self: T, keep: List[List[int]], threads: int = ...
+    ) -> List[T]: ...
+    def _select(
+        self: T,
+        slices: List[Any],
+        picks: Dict[int, int],
+        pick_sets: List[Any],
+        rebins: List[Any],
+        sums: Set[int],
+    ) -> T | Any: ...
+    def _sliced_axes(
+        self, slices: List[Any]
+    ) -> List[Tuple[axis._BaseAxis, int, int]]: ...
+    def _axes_state(self) -> Tuple[Any, ...]: ...
+    @classmethod
+    def _from_state(
+        cls: Type[T], axes_state: Tuple[Any, ...], buffer: ArrayLike
+    ) -> T: ...
 
 class any_int64(_BaseHistogram):
+    @staticmethod
+    def _from_buffer(
+        axes: Iterable[axis._BaseAxis], buffer: ArrayLike
+    ) -> any_int64: ...
+    def _shared_view(self) -> np.ndarray: ...
+    def _arrow_c_array(self, names: List[str]) -> Tuple[Any, Any]: ...
+    def _take_changes(self) -> Tuple[np.ndarray | None, np.ndarray]: ...
+    def _apply_changes(self, indices: ArrayLike | None, values: ArrayLike) -> None: ...
+    def _version(self) -> int | None: ...
     def __idiv__(self: T, other: any_int64) -> T: ...
     def __imul__(self: T, other: any_int64) -> T: ...
     def at(self, *args: int) -> int: ...
@@ -45,6 +89,15 @@ class any_unlimited(_BaseHistogram):
     def sum(self, flow: bool = ...) -> float: ...
 
 class any_double(_BaseHistogram):
+    @staticmethod
+    def _from_buffer(
+        axes: Iterable[axis._BaseAxis], buffer: ArrayLike
+    ) -> any_double: ...
+    def _shared_view(self) -> np.ndarray: ...
+    def _arrow_c_array(self, names: List[str]) -> Tuple[Any, Any]: ...
+    def _take_changes(self) -> Tuple[np.ndarray | None, np.ndarray]: ...
+    def _apply_changes(self, indices: ArrayLike | None, values: ArrayLike) -> None: ...
+    def _version(self) -> int | None: ...
     def __idiv__(self: T, other: any_double) -> T: ...
     def __imul__(self: T, other: any_double) -> T: ...
     def at(self, *args: int) -> float: ...
@@ -59,6 +112,15 @@ class any_atomic_int64(_BaseHistogram):
     def sum(self, flow: bool = ...) -> int: ...
 
 class any_weight(_BaseHistogram):
+    @staticmethod
+    def _from_buffer(
+        axes: Iterable[axis._BaseAxis], buffer: ArrayLike
+    ) -> any_weight: ...
+    def _shared_view(self) -> np.ndarray: ...
+    def _arrow_c_array(self, names: List[str]) -> Tuple[Any, Any]: ...
+    def _take_changes(self) -> Tuple[np.ndarray | None, np.ndarray]: ...
+    def _apply_changes(self, indices: ArrayLike | None, values: ArrayLike) -> None: ...
+    def _version(self) -> int | None: ...
     def __idiv__(self: T, other: any_weight) -> T: ...
     def __imul__(self: T, other: any_weight) -> T: ...
     def at(self, *args: int) -> accumulators.WeightedSum: ...
@@ -66,6 +128,15 @@ class any_weight(_BaseHistogram):
     def sum(self, flow: bool = ...) -> accumulators.WeightedSum: ...
 
 class any_mean(_BaseHistogram):
+    @staticmethod
+    def _from_buffer(
+        axes: Iterable[axis._BaseAxis], buffer: ArrayLike
+    ) -> any_mean: ...
+    def _shared_view(self) -> np.ndarray: ...
+    def _arrow_c_array(self, names: List[str]) -> Tuple[Any, Any]: ...
+    def _take_changes(self) -> Tuple[np.ndarray | None, np.ndarray]: ...
+    def _apply_changes(self, indices: ArrayLike | None, values: ArrayLike) -> None: ...
+    def _version(self) -> int | None: ...
     def at(self, *args: int) -> accumulators.Mean: ...
     def _at_set(self, value: accumulators.Mean, *args: int) -> None: ...
     def sum(self, flow: bool = ...) -> accumulators.Mean: ...
@@ -77,6 +148,15 @@ class any_mean(_BaseHistogram):
     ) -> None: ...
 
 class any_weighted_mean(_BaseHistogram):
+    @staticmethod
+    def _from_buffer(
+        axes: Iterable[axis._BaseAxis], buffer: ArrayLike
+    ) -> any_weighted_mean: ...
+    def _shared_view(self) -> np.ndarray: ...
+    def _arrow_c_array(self, names: List[str]) -> Tuple[Any, Any]: ...
+    def _take_changes(self) -> Tuple[np.ndarray | None, np.ndarray]: ...
+    def _apply_changes(self, indices: ArrayLike | None, values: ArrayLike) -> None: ...
+    def _version(self) -> int | None: ...
     def at(self, *args: int) -> accumulators.WeightedMean: ...
     def _at_set(self, value: accumulators.WeightedMean, *args: int) -> None: ...
     def sum(self, flow: bool = ...) -> accumulators.WeightedMean: ...
@@ -86,3 +166,31 @@ class any_weighted_mean(_BaseHistogram):
         weight: ArrayLike | None = ...,
         sample: ArrayLike | None = ...
     ) -> None: ...
+
+class any_mapped_int64(_BaseHistogram):
+    def __idiv__(self: T, other: any_mapped_int64) -> T: ...
+    def __imul__(self: T, other: any_mapped_int64) -> T: ...
+    def at(self, *args: int) -> int: ...
+    def _at_set(self, value: int, *args: int) -> None: ...
+    def sum(self, flow: bool = ...) -> int: ...
+
+class any_mapped_double(_BaseHistogram):
+    def __idiv__(self: T, other: any_mapped_double) -> T: ...
+    def __imul__(self: T, other: any_mapped_double) -> T: ...
+    def at(self, *args: int) -> float: ...
+    def _at_set(self, value: float, *args: int) -> None: ...
+    def sum(self, flow: bool = ...) -> float: ...
+
+class any_mapped_weight(_BaseHistogram):
+    def __idiv__(self: T, other: any_mapped_weight) -> T: ...
+    def __imul__(self: T, other: any_mapped_weight) -> T: ...
+    def at(self, *args: int) -> accumulators.WeightedSum: ...
+    def _at_set(self, value: accumulators.WeightedSum, *args: int) -> None: ...
+    def sum(self, flow: bool = ...) -> accumulators.WeightedSum: ...
+
+class any_shared_atomic_int64(_BaseHistogram):
+    def __idiv__(self: T, other: any_shared_atomic_int64) -> T: ...
+    def __imul__(self: T, other: any_shared_atomic_int64) -> T: ...
+    def at(self, *args: int) -> int: ...
+    def _at_set(self, value: int, *args: int) -> None: ...
+    def sum(self, flow: bool = ...) -> int: ...
@@ -1,4 +1,5 @@
-from typing import Any, TypeVar
+import enum
+from typing import Any, Tuple, TypeVar
 
 T = TypeVar("T", bound="_BaseStorage")
 
@@ -17,3 +18,27 @@ class unlimited(_BaseStorage): ...
 class weight(_BaseStorage): ...
 class mean(_BaseStorage): ...
 class weighted_mean(_BaseStorage): ...
+
+class _MappedStorage(_BaseStorage):
+    def __init__(self, path: str = ...) -> None: ...
+    @property
+    def path(self) -> str: ...
+
+class mapped_int64(_MappedStorage): ...
+class mapped_double(_MappedStorage): ...
+class mapped_weight(_MappedStorage): ...
+
+class shared_atomic_int64(_BaseStorage):
+    def __init__(self, name: str = ...) -> None: ...
+    @property
+    def path(self) -> str: ...
+    @staticmethod
+    def unlink(name: str) -> None: ...
+
+class huge_pages(enum.Enum):
+    none = enum.auto()
+    transparent = enum.auto()
+    hugetlb = enum.auto()
+
+def _set_allocation_policy(huge_pages: huge_pages, first_touch_threads: int) -> None: ...
+def _get_allocation_policy() -> Tuple[huge_pages, int]: ...
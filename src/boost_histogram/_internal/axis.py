@@ -50,7 +50,7 @@ T = TypeVar("T", bound="Axis")
 # Contains common methods and properties to all axes
 @set_module("boost_histogram.axis")
 class Axis:
-    __slots__ = ("_ax", "__dict__")
+    __slots__ = ("_ax", "_centers", "__dict__")
     _family: object
 
     def __init_subclass__(cls, *, family: object) -> None:
@@ -254,9 +254,16 @@ class Axis:
     @property
     def centers(self) -> np.ndarray:
         """
-        An array of bin centers.
+        An array of bin centers. It is computed once, since an axis only
+        changes by growing, which adds bins; each call returns a copy of it.
         """
-        return self._ax.centers  # type: ignore
+        cached = getattr(self, "_centers", None)
+        if cached is None or cached[0] is not self._ax or len(cached[1]) != len(self):
+            centers = self._ax.centers
+            centers.flags.writeable = False
+            cached = (self._ax, centers)
+            self._centers = cached
+        return cached[1].copy()  # type: ignore[no-any-return]
 
     @property
     def widths(self) -> np.ndarray:
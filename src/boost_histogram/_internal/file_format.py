@@ -0,0 +1,108 @@
+"""
+Binary file format written by Histogram.save and read by Histogram.load.
+
+The file starts with a fixed prefix: magic bytes, the format version, the size
+of the header and the offset of the data. The header is a pickled dict with
+the axes (serialized by the C++ archive, with their version numbers), the
+storage, the dtype and shape of ``view(flow=True)`` and the attributes of the
+Python histogram. The bin contents follow as one raw block in memory order
+(Fortran), starting on an allocation boundary so that it can be mapped.
+
+Since the header is a pickle, like the metadata it holds, reading a file can
+run arbitrary code: only read files from trusted sources, as with
+``pickle.load``.
+"""
+
+import pickle
+import struct
+from mmap import ALLOCATIONGRANULARITY
+from typing import Any, Dict, Tuple
+
+import numpy as np
+
+from .typing import PathLike
+
+MAGIC = b"BHIST\r\n\x1a"
+FORMAT_VERSION = 1
+
+_PREFIX = struct.Struct("<8sIQQ")
+
+
+def _round_up(n: int, multiple: int) -> int:
+    return (n + multiple - 1) // multiple * multiple
+
+
+def write(path: PathLike, header: Dict[str, Any], view: np.ndarray) -> None:
+    """
+    Write the header and the view with flow bins. The view is written without
+    a copy if it is Fortran-contiguous.
+    """
+    data = np.require(view, requirements="F")
+    header = dict(header, dtype=data.dtype, shape=data.shape)
+    header_bytes = pickle.dumps(header, protocol=pickle.HIGHEST_PROTOCOL)
+    offset = _round_up(_PREFIX.size + len(header_bytes), ALLOCATIONGRANULARITY)
+
+    with open(path, "wb") as f:
+        f.write(_PREFIX.pack(MAGIC, FORMAT_VERSION, len(header_bytes), offset))
+        f.write(header_bytes)
+        f.write(bytes(offset - f.tell()))
+        f.write(data.reshape(-1, order="A").view(np.uint8))
+
+
+def _parse_prefix(prefix: bytes, name: str) -> Tuple[int, int]:
+    """
+    Return the size of the header and the offset of the data.
+    """
+    if len(prefix) < _PREFIX.size or prefix[:8] != MAGIC:
+        raise ValueError(f"{name} is not a boost-histogram file")
+
+    _, version, header_size, offset = _PREFIX.unpack_from(prefix)
+    if version > FORMAT_VERSION:
+        raise RuntimeError(f"Cannot open boost-histogram file v{version}")
+    return header_size, offset
+
+
+def read(path: PathLike, *, mmap: bool) -> Tuple[Dict[str, Any], np.ndarray]:
+    """
+    Read the header and the view with flow bins. If mmap is True, the view is
+    a copy-on-write map of the file, so the bulk data is only read when it is
+    used and writes never reach the file.
+    """
+    with open(path, "rb") as f:
+        header_size, offset = _parse_prefix(f.read(_PREFIX.size), str(path))
+
+        header = pickle.loads(f.read(header_size))
+        dtype = header.pop("dtype")
+        shape = header.pop("shape")
+        count = int(np.prod(shape))
+
+        if mmap and count == 0:
+            # there is nothing after the offset to map
+            data = np.empty(0, dtype=dtype)
+        elif mmap:
+            data = np.memmap(f, dtype=dtype, mode="c", offset=offset, shape=(count,))
+        else:
+            f.seek(offset)
+            data = np.fromfile(f, dtype=dtype, count=count)
+            if data.size != count:
+                raise ValueError(f"{path} is truncated")
+
+    return header, data.reshape(shape, order="F")
+
+
+def parse(buffer: bytes) -> Tuple[Dict[str, Any], np.ndarray]:
+    """
+    Read the header and the view with flow bins from the contents of a file.
+    The view is a read-only array over the buffer.
+    """
+    header_size, offset = _parse_prefix(buffer, "buffer")
+
+    header = pickle.loads(buffer[_PREFIX.size : _PREFIX.size + header_size])
+    dtype = np.dtype(header.pop("dtype"))
+    shape = header.pop("shape")
+    count = int(np.prod(shape))
+    if len(buffer) < offset + count * dtype.itemsize:
+        raise ValueError("buffer is truncated")
+
+    data = np.frombuffer(buffer, dtype=dtype, count=count, offset=offset)
+    return header, data.reshape(shape, order="F")
@@ -1,20 +1,24 @@
 import collections.abc
 import copy
 import logging
+import os
 import threading
 import typing
 import warnings
+from concurrent.futures import Future, ThreadPoolExecutor
 from os import cpu_count
 from typing import (
     TYPE_CHECKING,
     Any,
     Callable,
     Dict,
+    Hashable,
     Iterable,
     List,
     Mapping,
     NewType,
     Optional,
+    Sequence,
     Set,
     Tuple,
     Type,
@@ -27,11 +31,12 @@ import numpy as np
 import boost_histogram
 import boost_histogram._core as _core
 
+from . import file_format
 from .axestuple import AxesTuple
 from .axis import Axis
 from .enum import Kind
-from .storage import Double, Storage
-from .typing import Accumulator, ArrayLike, CppHistogram, SupportsIndex
+from .storage import Double, Int64, Mean, Storage, Weight, WeightedMean
+from .typing import Accumulator, ArrayLike, CppHistogram, PathLike, SupportsIndex
 from .utils import cast, register, set_module
 from .view import MeanView, WeightedMeanView, WeightedSumView, _to_view
 
@@ -49,10 +54,36 @@ _histograms: Set[Type[CppHistogram]] = {
     _core.hist.any_weight,
     _core.hist.any_mean,
     _core.hist.any_weighted_mean,
+    _core.hist.any_mapped_int64,
+    _core.hist.any_mapped_double,
+    _core.hist.any_mapped_weight,
+    _core.hist.any_shared_atomic_int64,
 }
 
+# Storages that live in a memory-mapped file or segment, these cannot grow
+_mapped_storages = (
+    _core.storage.mapped_int64,
+    _core.storage.mapped_double,
+    _core.storage.mapped_weight,
+    _core.storage.shared_atomic_int64,
+)
+
 logger = logging.getLogger(__name__)
 
+# Checkpoints are written one at a time in the order they were taken
+_checkpoint_lock = threading.Lock()
+_checkpoint_executor: Optional[ThreadPoolExecutor] = None
+
+
+def _submit_checkpoint(fn: Callable[[], None]) -> "Future[None]":
+    global _checkpoint_executor
+    with _checkpoint_lock:
+        if _checkpoint_executor is None:
+            _checkpoint_executor = ThreadPoolExecutor(
+                max_workers=1, thread_name_prefix="boost_histogram-checkpoint"
+            )
+        return _checkpoint_executor.submit(fn)
+
 
 CppAxis = NewType("CppAxis", object)
 
@@ -91,6 +122,19 @@ def _arg_shortcut(item: Union[Tuple[int, float, float], Axis, CppAxis]) -> CppAx
         raise TypeError("Only axes supported in histogram constructor")
 
 
+def _storage_for_dtype(dtype: np.dtype) -> Storage:
+    if dtype.names == WeightedSumView._FIELDS:
+        return Weight()
+    elif dtype.names == MeanView._FIELDS:
+        return Mean()
+    elif dtype.names == WeightedMeanView._FIELDS:
+        return WeightedMean()
+    elif dtype == np.uint64:
+        return Int64()
+    else:
+        return Double()
+
+
 def _expand_ellipsis(indexes: Iterable[Any], rank: int) -> List[Any]:
     indexes = list(indexes)
     number_ellipses = indexes.count(Ellipsis)
@@ -112,6 +156,71 @@ def _expand_ellipsis(indexes: Iterable[Any], rank: int) -> List[Any]:
 H = TypeVar("H", bound="Histogram")
 
 
+def _read_only(array: np.ndarray) -> np.ndarray:
+    array.flags.writeable = False
+    return array
+
+
+def _mean_variances(view: Any) -> np.ndarray:
+    """
+    Variances of the means in a MeanView or WeightedMeanView, NaN where they
+    are undefined.
+    """
+    counts = view.sum_of_weights if hasattr(view, "sum_of_weights") else view.count
+    return _read_only(
+        np.divide(
+            view.variance,
+            counts,
+            out=np.full(counts.shape, np.nan),
+            where=counts > 1,
+        )
+    )
+
+
+def _effective_counts(view: Any) -> np.ndarray:
+    """
+    Effective counts of a WeightedMeanView, see Histogram.counts.
+    """
+    return _read_only(
+        np.divide(
+            view.sum_of_weights ** 2,
+            view.sum_of_weights_squared,
+            out=np.zeros_like(view.sum_of_weights, dtype=np.float64),
+            where=view.sum_of_weights_squared != 0,
+        )
+    )
+
+
+@set_module("boost_histogram")
+class HistogramDelta(typing.NamedTuple):
+    """
+    The cells of a histogram that changed between two snapshots, see
+    ``Histogram.snapshot_delta``. ``indices`` are flat indices into the view
+    with flow bins in Fortran order, or None if every cell is included, and
+    ``values`` are the new contents of these cells.
+    """
+
+    shape: Tuple[int, ...]
+    indices: Optional[np.ndarray]
+    values: np.ndarray
+
+
+class _Window(typing.NamedTuple):
+    """
+    A histogram selected by slices, which shares the cells of the histogram
+    it was taken from until either one is changed, see
+    ``Histogram._new_window``. ``hist`` is a copy of that histogram, which
+    ``slices`` select from, ``axes`` are the selected C++ axes and ``cells``
+    are the selected cells without flow bins, read-only, for sums and
+    projections.
+    """
+
+    hist: Any
+    slices: List[Any]
+    axes: Tuple[Any, ...]
+    cells: np.ndarray
+
+
 # We currently do not cast *to* a histogram, but this is consistent
 # and could be used later.
 @register(_histograms)  # type: ignore
@@ -119,11 +228,17 @@ H = TypeVar("H", bound="Histogram")
 class Histogram:
     # Note this is a __slots__ __dict__ class!
     __slots__ = (
-        "_hist",
+        "_unscaled",
+        "_scale",
+        "_window",
         "axes",
+        "_cache",
         "__dict__",
     )
     # .metadata and ._variance_known are part of the dict
+    # _cache holds results derived from the cells, it is never copied
+    # _unscaled is the C++ histogram before a pending scale factor, see _hist
+    # _window holds the cells of a slice until it needs a histogram of its own
 
     _family: object = boost_histogram
 
@@ -181,7 +296,7 @@ class Histogram:
 
         # Allow construction from a raw histogram object (internal)
         if len(axes) == 1 and isinstance(axes[0], tuple(_histograms)):
-            self._hist: Any = axes[0]
+            self._hist = axes[0]
             self.metadata = metadata
             self.axes = self._generate_axes_()
             return
@@ -221,6 +336,11 @@ class Histogram:
                 f"Too many axes, must be less than {_core.hist._axes_limit}"
             )
 
+        if isinstance(storage, _mapped_storages) and any(
+            ax.traits_growth for ax in axes  # type: ignore
+        ):
+            raise ValueError("Memory-mapped storages do not support growing axes")
+
         # Check all available histograms, and if the storage matches, return that one
         for h in _histograms:
             if isinstance(storage, h._storage_type):
@@ -268,6 +388,30 @@ class Histogram:
 
         return AxesTuple(self._axis(i) for i in range(self.ndim))
 
+    def _new_scaled(self: H, _hist: CppHistogram, memo: Any = NOTHING) -> H:
+        """
+        Like ``_new_hist``, for a _hist computed from the cells before the
+        pending scale factor, which the new histogram keeps pending.
+        """
+
+        other = self._new_hist(_hist, memo)
+        other._scale = self._scale
+        return other
+
+    def _scaled_sum(self, result: Any) -> Any:
+        """
+        Apply the pending scale factor to a sum of the cells.
+        """
+
+        scale = self._scale
+        if scale == 1.0:
+            return result
+        if isinstance(result, _core.accumulators.WeightedSum):
+            return _core.accumulators.WeightedSum(
+                result.value * scale, result.variance * scale**2
+            )
+        return result * scale
+
     def _new_hist(self: H, _hist: CppHistogram, memo: Any = NOTHING) -> H:
         """
         Return a new histogram given a new _hist, copying metadata.
@@ -288,11 +432,210 @@ class Histogram:
 
         return other
 
+    @property
+    def _hist(self) -> Any:
+        """
+        The C++ histogram. Multiplying or dividing a Double or Weight
+        histogram by a number only updates a pending scale factor, which
+        fills take into account by dividing their weights by it. Sums,
+        projections and copies carry the factor over to their result; any
+        other access applies it to the cells first.
+        """
+        hist = self._cells()
+        if self._scale != 1.0:
+            scale, self._scale = self._scale, 1.0
+            hist._inplace_op("__imul__", scale)
+        return hist
+
+    @_hist.setter
+    def _hist(self, value: Any) -> None:
+        self._unscaled = value
+        self._scale = 1.0
+        self._window = None
+
+    def _cells(self) -> Any:
+        """
+        The C++ histogram before the pending scale factor, see ``_hist``. A
+        slice that still shares the cells of the histogram it was taken from
+        gets cells of its own first, see ``_new_window``.
+        """
+        window = self._window
+        if window is not None:
+            self._unscaled = window.hist._select(window.slices, {}, [], [], set())
+            self._window = None
+        return self._unscaled
+
+    @property
+    def _cpp_storage_type(self) -> Any:
+        """
+        The C++ storage type, which is looked up without applying a pending
+        scale factor or giving a slice cells of its own.
+        """
+        window = self._window
+        return (window.hist if window is not None else self._unscaled)._storage_type
+
+    def _new_window(self: H, slices: List[Any]) -> H:
+        """
+        Return the histogram selected by the slices, which must not rebin.
+        It reads the cells of this histogram without a copy until it is
+        changed or needs cells of its own; sums and projections come from the
+        shared cells, while views and values give it cells of its own. Like a
+        copy, it does not see later changes to this histogram.
+
+        The shared cells are all cells of this histogram: the slice keeps them
+        alive, and this histogram copies all of them, not only the sliced
+        ones, when it is first changed. A slice with less than an eighth of
+        the cells therefore gets cells of its own right away.
+        """
+        hist = copy.copy(self._hist)
+        selected = hist._sliced_axes(slices)
+        cells = hist._shared_view()[
+            tuple(
+                slice(begin + ax.traits.underflow, end + ax.traits.underflow)
+                for ax, (_, begin, end) in zip(self.axes, selected)
+            )
+        ]
+
+        other = self.__class__.__new__(self.__class__)
+        other._unscaled = None
+        other._scale = 1.0
+        other._window = _Window(hist, slices, tuple(a for a, _, _ in selected), cells)
+        other.__dict__ = copy.copy(self.__dict__)
+        other.axes = other._generate_axes_()
+        for ax in other.axes:
+            ax.__dict__ = copy.copy(ax._ax.metadata)
+        if cells.size * 8 < hist.size():
+            other._cells()
+        return other
+
+    def _scale_lazily(self, name: str, other: Any) -> bool:
+        """
+        Fold multiplication or division by a number into the pending scale
+        factor, if possible. Factors that are not finite and nonzero, and
+        pending factors that would lose the cells to overflow or underflow,
+        are applied to the cells at once.
+        """
+        if name not in {"__imul__", "__itruediv__", "__idiv__"}:
+            return False
+        if isinstance(other, (bool, np.bool_)) or not isinstance(
+            other, (int, float, np.integer, np.floating)
+        ):
+            return False
+        if self._cells()._storage_type not in {
+            _core.storage.double,
+            _core.storage.weight,
+        }:
+            return False
+
+        factor = float(other)
+        if name != "__imul__":
+            if factor == 0.0:
+                return False
+            factor = 1.0 / factor
+        scale = self._scale * factor
+        if not 1e-100 < abs(scale) < 1e100:
+            return False
+        self._scale = scale
+        return True
+
+    def _cached(
+        self, key: Hashable, compute: Callable[[], T], *, scaled: bool = False
+    ) -> T:
+        """
+        Return ``compute()``, memoized until the cells change. Unless
+        ``scaled``, the pending scale factor is not applied first, and
+        ``compute`` must work on the cells before it, see ``_hist``. The C++
+        histogram bumps a version number on every change (fill, reset,
+        setting bins, arithmetic, views). Storages without one (atomic and
+        memory-mapped storages) compute the result every time, as do all
+        storages while a writable view of the cells is alive. ``compute``
+        must not take such a view, see ``_snapshot``.
+        """
+        hist = self._hist if scaled else self._cells()
+        version = hist._version() if hasattr(hist, "_version") else None
+        if version is None:
+            return compute()
+
+        cache = getattr(self, "_cache", None)
+        if cache is None or cache[0] is not hist or cache[1] != version:
+            cache = (hist, version, {})
+            self._cache = cache
+        results = cache[2]
+        if key not in results:
+            results[key] = compute()
+        return results[key]  # type: ignore[no-any-return]
+
+    def _snapshot(self, flow: bool) -> Any:
+        """
+        Return a read-only view of the cells. Unlike ``view``, this does not
+        keep changes from being tracked, see ``_cached``.
+        """
+        if self._window is not None and not flow:
+            return _to_view(self._window.cells)
+        if not hasattr(self._hist, "_shared_view"):
+            return self.view(flow)
+
+        view = _to_view(self._hist._shared_view())
+        if flow:
+            return view
+        start = [int(ax.traits.underflow) for ax in self.axes]
+        return view[tuple(slice(i, i + len(ax)) for i, ax in zip(start, self.axes))]
+
+    @classmethod
+    def from_view(
+        cls: Type[H],
+        axes: Iterable[Axis],
+        view: ArrayLike,
+        *,
+        storage: Optional[Storage] = None,
+        metadata: Any = None,
+    ) -> H:
+        """
+        Make a histogram with the given axes whose bin contents are ``view``,
+        which must have the shape of ``h.view(flow=True)``. If ``view`` is a
+        Fortran-ordered array with the dtype of the storage, the histogram uses
+        its memory directly and keeps it alive, so no copy is made (and changes
+        to one are seen in the other); otherwise it is copied. A read-only
+        array is copied when the histogram is first modified.
+
+        Parameters
+        ----------
+        axes : Iterable[Axis]
+            The axes of the histogram.
+        view : ArrayLike
+            The bin contents, including flow bins.
+        storage : Optional[Storage] = None
+            The storage to use; by default, this is picked from the dtype.
+        metadata : Any = None
+            Data that is passed along if a new histogram is created.
+        """
+
+        array = np.asarray(view)
+        if storage is None:
+            storage = _storage_for_dtype(array.dtype)
+
+        cpp_axes = [_arg_shortcut(ax) for ax in axes]
+
+        for h in _histograms:
+            if isinstance(storage, h._storage_type) and hasattr(h, "_from_buffer"):
+                return cls(h._from_buffer(cpp_axes, array), metadata=metadata)
+
+        # Storages that cannot adopt memory are filled from the array instead
+        result = cls(*axes, storage=storage, metadata=metadata)
+        if array.shape != result.axes.extent:
+            raise ValueError(
+                f"Wrong shape {array.shape}, expected {result.axes.extent}"
+            )
+        result.view(flow=True)[...] = array
+        return result
+
     @property
     def ndim(self) -> int:
         """
         Number of axes (dimensions) of the histogram.
         """
+        if self._window is not None:
+            return len(self._window.axes)
         return self._hist.rank()  # type: ignore
 
     def view(
@@ -306,6 +649,39 @@ class Histogram:
     def __array__(self) -> np.ndarray:
         return self.view(False)
 
+    def __dlpack__(self, **kwargs: Any) -> Any:
+        """
+        Export ``values()`` through DLPack, without a copy. The export keeps
+        the histogram alive and sees later changes to it. Needs NumPy 1.22+.
+        """
+        # a writable view, so a slice gets cells of its own and later changes
+        # are seen; NumPy only exports read-only arrays to newer consumers
+        view = self.view()
+        values = view if len(view.dtype) == 0 else view.value  # type: ignore
+        if not hasattr(values, "__dlpack__"):
+            raise BufferError("DLPack export needs NumPy 1.22 or later")
+        return values.__dlpack__(**kwargs)
+
+    def __dlpack_device__(self) -> Tuple[int, int]:
+        return (1, 0)  # kDLCPU
+
+    def __arrow_c_array__(self, requested_schema: Any = None) -> Tuple[Any, Any]:
+        """
+        Export the bins and values as an Arrow record batch with one row per
+        bin, flow bins included, through the Arrow PyCapsule interface (for
+        example ``pyarrow.record_batch(h)``). There is one int32 column
+        ``bin0``, ``bin1``, ... per axis with the bin index (-1 is the
+        underflow bin), then one column per field of the storage. Values made
+        of a single number are not copied. The export is a snapshot: later
+        changes to the histogram are not seen. ``requested_schema`` is
+        ignored, as the interface allows.
+        """
+        hist = self._hist
+        if not hasattr(hist, "_arrow_c_array"):
+            # storages that cannot be shared, like atomic or unlimited, are copied
+            hist = Histogram.from_view(self.axes, self.view(flow=True))._hist
+        return hist._arrow_c_array([f"bin{i}" for i in range(self.ndim)])
+
     def __eq__(self, other: Any) -> bool:
         return hasattr(other, "_hist") and self._hist == other._hist
 
@@ -358,33 +734,16 @@ class Histogram:
         self: H, name: str, other: Union["Histogram", np.ndarray, float]
     ) -> H:
         # Also takes CppHistogram, but that confuses mypy because it's hard to pick out
-        if isinstance(other, Histogram):
+        if self._scale_lazily(name, other):
+            pass
+        elif isinstance(other, Histogram):
             getattr(self._hist, name)(other._hist)
         elif isinstance(other, tuple(_histograms)):
             getattr(self._hist, name)(other)
-        elif hasattr(other, "shape") and other.shape:  # type: ignore
-            assert not isinstance(other, float)
-            if len(other.shape) != self.ndim:
-                raise ValueError(
-                    "Number of dimensions {} must match histogram {}".format(
-                        len(other.shape), self.ndim
-                    )
-                )
-            elif all(a in {b, 1} for a, b in zip(other.shape, self.shape)):
-                view = self.view(flow=False)
-                getattr(view, name)(other)
-            elif all(a in {b, 1} for a, b in zip(other.shape, self.axes.extent)):
-                view = self.view(flow=True)
-                getattr(view, name)(other)
-            else:
-                raise ValueError(
-                    "Wrong shape {}, expected {} or {}".format(
-                        other.shape, self.shape, self.axes.extent
-                    )
-                )
         else:
-            view = self.view(flow=True)
-            getattr(view, name)(other)
+            # Arrays are broadcast against the bins without flow bins if they
+            # fit, otherwise against all bins; numbers apply to all bins
+            self._hist._inplace_op(name, other)
         self._variance_known = False
         return self
 
@@ -413,10 +772,16 @@ class Histogram:
             available threads (usually two per core).
         """
 
+        # Fills go to the unscaled cells, with weights divided by the pending
+        # scale factor, which is only ever set for Double and Weight storages
+        hist = self._cells()
+        scale = self._scale
+
         if (
-            self._hist._storage_type
+            hist._storage_type
             not in {
                 _core.storage.weight,
+                _core.storage.mapped_weight,
                 _core.storage.mean,
                 _core.storage.weighted_mean,
             }
@@ -428,15 +793,20 @@ class Histogram:
         args_ars = _fill_cast(args)
         weight_ars = _fill_cast(weight)
         sample_ars = _fill_cast(sample)
+        if scale != 1.0:
+            if weight is None:
+                weight_ars = 1.0 / scale
+            else:
+                weight_ars = np.asarray(weight_ars) / scale
 
         if threads is None or threads == 1:
-            self._hist.fill(*args_ars, weight=weight_ars, sample=sample_ars)
+            hist.fill(*args_ars, weight=weight_ars, sample=sample_ars)
             return self
 
         if threads == 0:
             threads = cpu_count()
 
-        if self._hist._storage_type in {
+        if hist._storage_type in {
             _core.storage.mean,
             _core.storage.weighted_mean,
         }:
@@ -444,7 +814,7 @@ class Histogram:
 
         data = [np.array_split(a, threads) for a in args_ars]
 
-        if weight is None or np.isscalar(weight):
+        if weight is None or np.isscalar(weight_ars):
             assert threads is not None
             weights = [weight_ars] * threads
         else:
@@ -456,14 +826,17 @@ class Histogram:
         else:
             samples = np.array_split(sample_ars, threads)
 
-        if self._hist._storage_type is _core.storage.atomic_int64:
+        if hist._storage_type in {
+            _core.storage.atomic_int64,
+            _core.storage.shared_atomic_int64,
+        }:
 
             def fun(
                 weight: Optional[ArrayLike],
                 sample: Optional[ArrayLike],
                 *args: np.ndarray,
             ) -> None:
-                self._hist.fill(*args, weight=weight, sample=sample)
+                hist.fill(*args, weight=weight, sample=sample)
 
         else:
             sum_lock = threading.Lock()
@@ -473,11 +846,10 @@ class Histogram:
                 sample: Optional[ArrayLike],
                 *args: np.ndarray,
             ) -> None:
-                local_hist = self._hist.__copy__()
-                local_hist.reset()
+                local_hist = hist._empty_clone()
                 local_hist.fill(*args, weight=weight, sample=sample)
                 with sum_lock:
-                    self._hist += local_hist
+                    self._unscaled += local_hist
 
         thread_list = [
             threading.Thread(target=fun, args=arrays)
@@ -510,37 +882,42 @@ class Histogram:
         """
         Get N-th axis.
         """
+        if self._window is not None:
+            return cast(self, self._window.axes[i], Axis)
         return cast(self, self._hist.axis(i), Axis)
 
     @property
     def _storage_type(self) -> Type[Storage]:
-        return cast(self, self._hist._storage_type, Storage)  # type: ignore
+        return cast(self, self._cpp_storage_type, Storage)  # type: ignore
 
     def _reduce(self: H, *args: Any) -> H:
         return self._new_hist(self._hist.reduce(*args))
 
     def __copy__(self: H) -> H:
-        return self._new_hist(copy.copy(self._hist))
+        return self._new_scaled(copy.copy(self._cells()))
 
     def __deepcopy__(self: H, memo: Any) -> H:
-        return self._new_hist(copy.deepcopy(self._hist), memo=memo)
+        return self._new_scaled(copy.deepcopy(self._cells()), memo=memo)
 
     def __getstate__(self) -> Tuple[int, Dict[str, Any]]:
         """
         Version 0.8: metadata added
         Version 0.11: version added and set to 0. metadata/_hist replaced with dict.
         Version 0.12: _variance_known is now in the dict (no format change)
+        Version 1.2: version 1 if a string category axis is saved packed, so
+        that older releases refuse it with a clear error
 
         ``dict`` contains __dict__ with added "_hist"
         """
         local_dict = copy.copy(self.__dict__)
         local_dict["_hist"] = self._hist
-        # Version 0 of boost-histogram pickle state
-        return (0, local_dict)
+        str_axes = (_core.axis.category_str, _core.axis.category_str_growth)
+        packed = any(isinstance(ax._ax, str_axes) for ax in self.axes)
+        return (1 if packed else 0, local_dict)
 
     def __setstate__(self, state: Any) -> None:
         if isinstance(state, tuple):
-            if state[0] == 0:
+            if state[0] in {0, 1}:
                 for key, value in state[1].items():
                     setattr(self, key, value)
 
@@ -560,6 +937,110 @@ class Histogram:
 
         self.axes = self._generate_axes_()
 
+    def save(self, path: PathLike) -> None:
+        """
+        Save the histogram to a binary file that ``Histogram.load`` can read.
+        The bin contents are written as one raw block, so they can be mapped
+        into memory when loading instead of being read.
+        """
+        state = {k: v for k, v in self.__dict__.items() if k not in {"_hist", "axes"}}
+        header = {
+            "axes": self._hist._axes_state(),
+            "storage": self._storage_type,
+            "state": state,
+        }
+        # a shared view does not copy the cells, also not on the next fill
+        if hasattr(self._hist, "_shared_view"):
+            view = self._hist._shared_view()
+        else:
+            view = self._hist.view(True)
+        file_format.write(path, header, view)
+
+    def checkpoint_async(self, path: PathLike) -> "Future[None]":
+        """
+        Save a snapshot of the histogram like ``save``, on a background thread.
+        The snapshot holds all fills that completed before the call, and is
+        cheap to take: the bin contents are shared with the histogram until it
+        is changed next. The file is replaced once it is complete, so an
+        interrupted checkpoint leaves the previous one intact. Returns a future
+        that is done when the file is written. A checkpoint taken on another
+        thread while a fill runs waits for the fill to finish; with unlimited,
+        atomic or memory-mapped storages, take it on the filling thread.
+        """
+        snapshot = self.copy()
+        target = os.fspath(path)
+
+        def write() -> None:
+            partial = f"{target}.partial"
+            snapshot.save(partial)
+            os.replace(partial, target)
+
+        return _submit_checkpoint(write)
+
+    @classmethod
+    def load(cls: Type[H], path: PathLike, *, mmap: bool = True) -> H:
+        """
+        Load a histogram saved with ``Histogram.save``. If ``mmap`` is True,
+        the bin contents are mapped copy-on-write from the file and only read
+        when they are used; changes to the histogram never reach the file.
+
+        The file holds pickled metadata, so loading it can run arbitrary code,
+        like ``pickle.load``. Only load files from trusted sources.
+        """
+        header, data = file_format.read(path, mmap=mmap)
+        return cls._from_header(header, data)
+
+    @classmethod
+    def _from_header(cls: Type[H], header: Dict[str, Any], data: np.ndarray) -> H:
+        for h in _histograms:
+            if issubclass(header["storage"], h._storage_type):
+                _hist = h._from_state(header["axes"], data)
+                break
+        else:
+            raise TypeError("Unsupported storage")
+
+        result = cls.__new__(cls)
+        result.__setstate__((0, dict(header["state"], _hist=_hist)))
+        return result
+
+    def snapshot_delta(self) -> HistogramDelta:
+        """
+        Return the cells that changed since the previous call, so a copy that
+        was in sync can be updated with ``apply_delta``. The first call, and
+        any call after an operation that may touch every cell (like arithmetic,
+        taking a view, or growing an axis), returns all cells. After filling or
+        setting bins, only the cells that were written are returned; dense
+        storages record them in a bitmap while filling, so a snapshot neither
+        copies nor scans the cells. Storages that cannot record changes always
+        return all cells.
+        """
+        if hasattr(self._hist, "_take_changes"):
+            indices, values = self._hist._take_changes()
+        else:
+            indices = None
+            values = np.array(self._hist.view(True)).reshape(-1, order="F")
+        return HistogramDelta(self.axes.extent, indices, values)
+
+    def apply_delta(self: H, delta: HistogramDelta) -> H:
+        """
+        Set the cells in ``delta``, from ``snapshot_delta`` on a histogram
+        with the same axes, to their new contents.
+        """
+        if tuple(delta.shape) != self.axes.extent:
+            raise ValueError(
+                f"Wrong shape {tuple(delta.shape)}, expected {self.axes.extent}"
+            )
+        if hasattr(self._hist, "_apply_changes"):
+            self._hist._apply_changes(delta.indices, delta.values)
+            return self
+
+        view = self._hist.view(True)
+        if delta.indices is None:
+            view[...] = np.reshape(delta.values, view.shape, order="F")
+        else:
+            view[np.unravel_index(delta.indices, view.shape, order="F")] = delta.values
+        return self
+
     def __repr__(self) -> str:
         newline = "\n  "
         sep = "," if len(self.axes) > 0 else ""
@@ -673,8 +1154,11 @@ class Histogram:
             The edges for each dimension
         """
 
-        hist, *edges = self._hist.to_numpy(flow)
-        hist = self.view(flow=flow) if view else self.values(flow=flow)
+        # the cells come as a view, which is only taken once
+        cells, *edges = self._hist.to_numpy(flow)
+        hist = _to_view(cells)
+        if not view and len(hist.dtype) > 0:  # type: ignore
+            hist = hist.value  # type: ignore
 
         if dd:
             return (hist, edges)
@@ -697,7 +1181,8 @@ class Histogram:
         """
         Reset bin counters to default values.
         """
-        self._hist.reset()
+        self._scale = 1.0
+        self._cells().reset()
         return self
 
     def empty(self, flow: bool = False) -> bool:
@@ -705,19 +1190,40 @@ class Histogram:
         Check to see if the histogram has any non-default values.
         You can use flow=True to check flow bins too.
         """
-        return self._hist.empty(flow)  # type: ignore
+        # the pending scale factor is never zero
+        return self._cached(("empty", flow), lambda: self._cells().empty(flow))
 
     def sum(self, flow: bool = False) -> Union[float, Accumulator]:
         """
         Compute the sum over the histogram bins (optionally including the flow bins).
         """
-        return self._hist.sum(flow)  # type: ignore
+        window = self._window
+        if window is not None:
+            if flow:
+                every = set(range(self.ndim))
+                return window.hist._select(  # type: ignore[no-any-return]
+                    window.slices, {}, [], [], every
+                )
+            storage = self._cpp_storage_type
+            if storage in {_core.storage.int64, _core.storage.double}:
+                return float(window.cells.sum())
+            if storage is _core.storage.weight:
+                cells = _to_view(window.cells)
+                return _core.accumulators.WeightedSum(
+                    float(cells.value.sum()), float(cells.variance.sum())
+                )
+
+        # accumulators are mutable, so the cached one is never handed out
+        total = self._cached(("sum", flow), lambda: self._cells().sum(flow))
+        return self._scaled_sum(copy.copy(total))
 
     @property
     def size(self) -> int:
         """
         Total number of bins in the histogram (including underflow/overflow).
         """
+        if self._window is not None:
+            return int(np.prod(self.axes.extent))
         return self._hist.size()  # type: ignore
 
     @property
@@ -745,7 +1251,9 @@ class Histogram:
         integrations: Set[int] = set()
         slices: List[_core.algorithm.reduce_command] = []
         pick_each: Dict[int, int] = dict()
-        pick_set: Dict[int, List[int]] = dict()
+        pick_sets: List[_core.algorithm.pick_set_command] = []
+        rebins: List[_core.algorithm.rebin_edges_command] = []
+        merged = False
 
         # Compute needed slices and projections
         for i, ind in enumerate(indexes):
@@ -755,7 +1263,7 @@ class Histogram:
                 )
                 continue
             elif isinstance(ind, collections.abc.Sequence):
-                pick_set[i] = list(ind)
+                pick_sets.append(_core.algorithm.pick_set(i, list(ind)))
                 continue
             elif not isinstance(ind, slice):
                 raise IndexError(
@@ -774,6 +1282,12 @@ class Histogram:
 
             if ind != slice(None):
                 merge = 1
+                if getattr(ind.step, "edges", None) is not None:
+                    if ind.start is not None or ind.stop is not None:
+                        raise IndexError("Cannot slice and rebin onto edges at once")
+                    edges = [float(e) for e in ind.step.edges]  # type: ignore
+                    rebins.append(_core.algorithm.rebin_edges(i, edges))
+                    continue
                 if ind.step is not None:
                     if hasattr(ind.step, "factor"):
                         merge = ind.step.factor
@@ -797,58 +1311,32 @@ class Histogram:
 
                 assert isinstance(start, int)
                 assert isinstance(stop, int)
+                merged = merged or merge != 1
                 slices.append(_core.algorithm.slice_and_rebin(i, start, stop, merge))
 
-        logger.debug("Reduce with %s", slices)
-        reduced = self._hist.reduce(*slices)
+        logger.debug(
+            "Select with slices %s, picks %s, sets %s, rebins %s, sums %s",
+            slices,
+            pick_each,
+            pick_sets,
+            rebins,
+            integrations,
+        )
+        # Plain slices share the cells until they are needed on their own
+        if (
+            not (merged or pick_each or pick_sets or rebins or integrations)
+            and self._window is None
+            and hasattr(self._hist, "_shared_view")
+        ):
+            return self._new_window(slices)
 
-        if pick_set:
-            warnings.warn(
-                "List indexing selection is experimental. Removed bins are not placed in overflow."
-            )
-            logger.debug("Slices for picking sets: %s", pick_set)
-            axes = [reduced.axis(i) for i in range(reduced.rank())]
-            reduced_view = reduced.view(flow=True)
-            for i in pick_set:
-                selection = copy.copy(pick_set[i])
-                ax = reduced.axis(i)
-                if ax.traits_ordered:
-                    raise RuntimeError(
-                        f"Axis {i} is not a categorical axis, cannot pick with list"
-                    )
-
-                if ax.traits_overflow and ax.size not in pick_set[i]:
-                    selection.append(ax.size)
-
-                new_axis = axes[i].__class__([axes[i].value(j) for j in pick_set[i]])
-                new_axis.metadata = axes[i].metadata
-                axes[i] = new_axis
-                reduced_view = np.take(reduced_view, selection, axis=i)
-
-            logger.debug("Axes: %s", axes)
-            new_reduced = reduced.__class__(axes)
-            new_reduced.view(flow=True)[...] = reduced_view
-            reduced = new_reduced
-
-        if pick_each:
-            tuple_slice = tuple(
-                pick_each.get(i, slice(None)) for i in range(reduced.rank())
-            )
-            logger.debug("Slices for pick each: %s", tuple_slice)
-            axes = [
-                reduced.axis(i) for i in range(reduced.rank()) if i not in pick_each
-            ]
-            logger.debug("Axes: %s", axes)
-            new_reduced = reduced.__class__(axes)
-            new_reduced.view(flow=True)[...] = reduced.view(flow=True)[tuple_slice]
-            reduced = new_reduced
-            integrations = {i - sum(j <= i for j in pick_each) for i in integrations}
-
-        if integrations:
-            projections = [i for i in range(reduced.rank()) if i not in integrations]
-            reduced = reduced.project(*projections)
-
-        return self._new_hist(reduced) if reduced.rank() > 0 else reduced.sum(flow=True)
+        reduced = self._hist._select(
+            slices, pick_each, pick_sets, rebins, integrations
+        )
+
+        if isinstance(reduced, type(self._hist)):
+            return self._new_hist(reduced)
+        return reduced  # type: ignore
 
     def __setitem__(
         self, index: IndexingExpr, value: Union[ArrayLike, Accumulator]
@@ -964,7 +1452,126 @@ class Histogram:
         those axes only. Flow bins are used if available.
         """
 
-        return self._new_hist(self._hist.project(*args))
+        window = self._window
+        keep = [int(i) for i in args]
+        if (
+            window is not None
+            and keep
+            and len(set(keep)) == len(keep)
+            and all(0 <= i < self.ndim for i in keep)
+        ):
+            # sum over the other axes of the selection in one pass, then
+            # put the kept axes in order
+            summed = set(range(self.ndim)) - set(keep)
+            selected = window.hist._select(window.slices, {}, [], [], summed)
+            if keep != sorted(keep):
+                selected = selected.project(*(sorted(keep).index(i) for i in keep))
+            return self._new_hist(selected)
+
+        projected = self._cached(
+            ("project", *args), lambda: self._cells().project(*args)
+        )
+        # copies share the cells until either one is changed
+        return self._new_scaled(copy.copy(projected))
+
+    def project_many(
+        self: H, *subsets: Sequence[int], threads: Optional[int] = None
+    ) -> List[H]:
+        """
+        Compute several projections at once, one for each sequence of axis
+        numbers, like ``[self.project(*s) for s in subsets]``. Dense storages
+        are projected in a single pass over the bins, on ``threads`` threads
+        (the number of CPUs by default), for example to get every 1D marginal
+        with ``h.project_many(*((i,) for i in range(h.ndim)))``.
+        """
+
+        keep = [[int(i) for i in s] for s in subsets]
+        projected = self._cells()._project_many(keep, threads or 0)
+        return [self._new_scaled(h) for h in projected]
+
+    def _summed_area_tables(self, threads: int) -> Tuple[np.dtype, List[np.ndarray]]:
+        """
+        Return the dtype of the cells and the summed-area table (with flow
+        bins) of each field.
+        """
+        return self._cached(
+            "summed_area_tables",
+            lambda: self._make_summed_area_tables(threads),
+            scaled=True,
+        )
+
+    def _make_summed_area_tables(
+        self, threads: int
+    ) -> Tuple[np.dtype, List[np.ndarray]]:
+        view = np.asarray(self._snapshot(True))
+        if view.dtype.names not in {None, ("value", "variance")}:
+            raise TypeError("Only histograms of counts or weights can be integrated")
+
+        names = view.dtype.names
+        fields = [view] if names is None else [view[n] for n in names]
+        tables = []
+        for field in fields:
+            dtype = np.uint64 if field.dtype.kind == "u" else np.float64
+            array = np.asfortranarray(field, dtype=dtype)
+            tables.append(_core.algorithm.summed_area_table(array, threads))
+        return view.dtype, tables
+
+    def integrate(
+        self,
+        lower: ArrayLike,
+        upper: ArrayLike,
+        *,
+        threads: Optional[int] = None,
+    ) -> Any:
+        """
+        Sum the bins in a box, from the bin indices in ``lower`` up to, but not
+        including, the bin indices in ``upper``, one per axis. Index -1 is the
+        underflow bin and ``len(axis)`` the overflow bin, bounds beyond these
+        are clipped. Arrays of shape ``(n, ndim)`` give the sums over ``n``
+        boxes at once, as an array (a view for Weight storages).
+
+        The first call builds a table of cumulative sums of the bins, on
+        ``threads`` threads (the number of CPUs by default). Each sum then
+        takes the same time, however many bins the box holds. The table is
+        kept until the histogram changes; it is rebuilt on every call while a
+        writable view of the histogram is alive, or for atomic and
+        memory-mapped storages.
+
+        For floating-point storages, the table holds sums of many bins, which
+        are rounded relative to their size. The sum over a small box next to
+        bins with large contents is only as precise as those sums, so it can
+        be off by about ``1e-16`` times the total below the box.
+        """
+
+        lower_bins = np.asarray(lower, dtype=np.intp)
+        upper_bins = np.asarray(upper, dtype=np.intp)
+        single = lower_bins.ndim == 1
+        if lower_bins.shape != upper_bins.shape or lower_bins.shape[-1:] != (
+            self.ndim,
+        ):
+            raise ValueError("lower and upper need one bin index per axis")
+
+        underflow = np.array([ax.traits.underflow for ax in self.axes], dtype=np.intp)
+        lower_bins = lower_bins.reshape(-1, self.ndim) + underflow
+        upper_bins = upper_bins.reshape(-1, self.ndim) + underflow
+
+        dtype, tables = self._summed_area_tables(threads or 0)
+        sums = [
+            _core.algorithm.box_sums(table, lower_bins, upper_bins, threads or 0)
+            for table in tables
+        ]
+
+        if dtype.names is None:
+            return float(sums[0][0]) if single else sums[0]
+
+        if single:
+            return _core.accumulators.WeightedSum(
+                float(sums[0][0]), float(sums[1][0])
+            )
+        result = np.empty(len(sums[0]), dtype=dtype)
+        result["value"] = sums[0]
+        result["variance"] = sums[1]
+        return _to_view(result)
 
     # Implementation of PlottableHistogram
 
@@ -976,7 +1583,7 @@ class Histogram:
 
         :return: Kind
         """
-        if self._hist._storage_type in {
+        if self._cpp_storage_type in {
             _core.storage.mean,
             _core.storage.weighted_mean,
         }:
@@ -1023,33 +1630,26 @@ class Histogram:
         Currently, this always returns - but in the future, it will return None
         if a weighted fill is made on a unweighed storage.
 
+        For profiles, the result is computed once until the histogram changes;
+        each call returns a copy of it.
+
         :param flow: Enable flow bins. Not part of PlottableHistogram, but
         included for consistency with other methods and flexibility.
 
         :return: np.ndarray[np.float64]
         """
 
+        if self.kind == Kind.MEAN:
+            return self._cached(
+                ("variances", flow), lambda: _mean_variances(self._snapshot(flow))
+            ).copy()
+
         view = self.view(flow)
         if len(view.dtype) == 0:  # type: ignore
             if self._variance_known:
                 return view
             else:
                 return None
-        elif hasattr(view, "sum_of_weights"):
-            return np.divide(  # type: ignore
-                view.variance,  # type: ignore
-                view.sum_of_weights,  # type: ignore
-                out=np.full(view.sum_of_weights.shape, np.nan),  # type: ignore
-                where=view.sum_of_weights > 1,  # type: ignore
-            )
-
-        elif hasattr(view, "count"):
-            return np.divide(  # type: ignore
-                view.variance,  # type: ignore
-                view.count,  # type: ignore
-                out=np.full(view.count.shape, np.nan),  # type: ignore
-                where=view.count > 1,  # type: ignore
-            )
         else:
             return view.variance  # type: ignore
 
@@ -1072,21 +1672,21 @@ class Histogram:
         the bin was filled, the equality holds when all filled weights are equal.
         The larger the spread in weights, the smaller it is, but it is always 0
         if filled 0 times, and 1 if filled once, and more than 1 otherwise.
+        These effective counts are computed once until the histogram changes;
+        each call returns a copy of them.
 
         :return: np.ndarray[np.float64]
         """
 
+        if self._cpp_storage_type is _core.storage.weighted_mean:
+            return self._cached(
+                ("counts", flow), lambda: _effective_counts(self._snapshot(flow))
+            ).copy()
+
         view = self.view(flow)
 
         if len(view.dtype) == 0:  # type: ignore
             return view
-        elif hasattr(view, "sum_of_weights"):
-            return np.divide(  # type: ignore
-                view.sum_of_weights ** 2,  # type: ignore
-                view.sum_of_weights_squared,  # type: ignore
-                out=np.zeros_like(view.sum_of_weights, dtype=np.float64),  # type: ignore
-                where=view.sum_of_weights_squared != 0,  # type: ignore
-            )
         elif hasattr(view, "count"):
             return view.count  # type: ignore
         else:
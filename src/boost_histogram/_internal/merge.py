@@ -0,0 +1,116 @@
+"""
+Summing of many histograms, see sum_histograms and merge_files.
+
+For merge_files, the calling thread reads the files ahead into a bounded queue.
+Worker threads decode them and add each one into a running total of their own.
+The totals are then summed with sum_histograms. Cells of dense storages are
+added without holding the GIL, so the workers run in parallel for most of the
+time.
+"""
+
+import pickle
+import queue
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from os import cpu_count
+from typing import Iterable, List, Optional, TypeVar
+
+from . import file_format
+from .hist import Histogram
+from .typing import PathLike
+from .utils import set_module
+
+H = TypeVar("H", bound=Histogram)
+
+
+def _decode(buffer: bytes) -> Histogram:
+    if buffer[: len(file_format.MAGIC)] == file_format.MAGIC:
+        header, data = file_format.parse(buffer)
+        return Histogram._from_header(header, data)
+
+    hist = pickle.loads(buffer)
+    if not isinstance(hist, Histogram):
+        raise TypeError(f"Expected a pickled histogram, got {type(hist).__name__}")
+    return hist
+
+
+def _merge(total: Histogram, other: Histogram) -> Histogram:
+    total._hist._merge(other._hist)
+    total._variance_known = total._variance_known and other._variance_known
+    return total
+
+
+@set_module("boost_histogram")
+def sum_histograms(hists: Iterable[H], *, threads: Optional[int] = None) -> H:
+    """
+    Sum histograms with the same axes and storage into a new histogram with
+    the type and metadata of the first one. The axes are compared once, and
+    the cells are added into a single new storage on ``threads`` threads (the
+    number of CPUs by default), without intermediate histograms.
+    """
+    hists = list(hists)
+    if not hists:
+        raise ValueError("No histograms to sum")
+    cpp_type = type(hists[0]._hist)
+    if any(type(h._hist) is not cpp_type for h in hists):
+        raise TypeError("Histograms must have the same storage")
+
+    result = hists[0]._new_hist(cpp_type._sum([h._hist for h in hists], threads or 0))
+    result._variance_known = all(h._variance_known for h in hists)
+    return result
+
+
+@set_module("boost_histogram")
+def merge_files(
+    paths: Iterable[PathLike], *, threads: Optional[int] = None
+) -> Histogram:
+    """
+    Sum histograms from files written by ``Histogram.save`` or by pickling.
+    The files are read ahead on the calling thread and decoded and added on
+    ``threads`` worker threads (the number of CPUs by default). At most a few
+    histograms per thread are in memory at once. The result has the type and
+    metadata of one of the inputs. Like ``Histogram.load``, this can run
+    arbitrary code from the files, so only pass files from trusted sources.
+    """
+    if threads is None:
+        threads = cpu_count() or 1
+    if threads < 1:
+        raise ValueError("threads must be positive")
+
+    pending: "queue.Queue[Optional[bytes]]" = queue.Queue(maxsize=threads)
+    failed = threading.Event()
+
+    def work() -> Optional[Histogram]:
+        total: Optional[Histogram] = None
+        try:
+            while True:
+                buffer = pending.get()
+                if buffer is None:
+                    return total
+                hist = _decode(buffer)
+                total = hist if total is None else _merge(total, hist)
+        except BaseException:
+            failed.set()
+            # keep draining, so that the reader never blocks on a full queue
+            while pending.get() is not None:
+                pass
+            raise
+
+    with ThreadPoolExecutor(max_workers=threads) as pool:
+        workers = [pool.submit(work) for _ in range(threads)]
+        try:
+            for path in paths:
+                if failed.is_set():
+                    break
+                with open(path, "rb") as f:
+                    pending.put(f.read())
+        finally:
+            for _ in range(threads):
+                pending.put(None)
+
+        results = (worker.result() for worker in workers)
+        totals: List[Histogram] = [t for t in results if t is not None]
+
+    if not totals:
+        raise ValueError("No histograms to merge")
+    return sum_histograms(totals, threads=threads)
@@ -1,3 +1,6 @@
+from os import cpu_count
+from typing import Any, Dict, Optional
+
 import boost_histogram
 
 from .._core import storage as store
@@ -49,3 +52,73 @@ class Mean(store.mean, Storage, family=boost_histogram):
 @set_module("boost_histogram.storage")
 class WeightedMean(store.weighted_mean, Storage, family=boost_histogram):
     pass
+
+
+@set_module("boost_histogram.storage")
+class MappedInt64(store.mapped_int64, Storage, family=boost_histogram):
+    def __repr__(self) -> str:
+        return f"{self.__class__.__name__}({self.path!r})"
+
+
+@set_module("boost_histogram.storage")
+class MappedDouble(store.mapped_double, Storage, family=boost_histogram):
+    def __repr__(self) -> str:
+        return f"{self.__class__.__name__}({self.path!r})"
+
+
+@set_module("boost_histogram.storage")
+class MappedWeight(store.mapped_weight, Storage, family=boost_histogram):
+    def __repr__(self) -> str:
+        return f"{self.__class__.__name__}({self.path!r})"
+
+
+@set_module("boost_histogram.storage")
+class SharedAtomicInt64(store.shared_atomic_int64, Storage, family=boost_histogram):
+    def __repr__(self) -> str:
+        return f"{self.__class__.__name__}({self.path!r})"
+
+
+def set_allocation_policy(
+    *, huge_pages: str = "none", first_touch_threads: Optional[int] = None
+) -> None:
+    """
+    Select how the dense storages allocate memory. Small buffers are always
+    aligned to cache lines; this affects buffers of 2 MiB and more, and only
+    storages allocated after the call.
+
+    Parameters
+    ----------
+    huge_pages : str = "none"
+        "transparent" advises the kernel to back large buffers with
+        transparent huge pages, "hugetlb" takes them from the reserved huge
+        page pool (falling back to normal pages if it is exhausted).
+    first_touch_threads : Optional[int] = None
+        Zero large buffers from this many threads when they are allocated, so
+        that on NUMA systems their pages are spread over the nodes. None (or 1)
+        disables this, 0 picks the number of available threads.
+    """
+
+    if first_touch_threads is None:
+        first_touch_threads = 1
+    elif first_touch_threads == 0:
+        first_touch_threads = cpu_count() or 1
+
+    try:
+        pages = getattr(store.huge_pages, huge_pages)
+    except AttributeError:
+        msg = f"huge_pages must be 'none', 'transparent', or 'hugetlb', not {huge_pages!r}"
+        raise ValueError(msg) from None
+
+    store._set_allocation_policy(pages, first_touch_threads)
+
+
+def get_allocation_policy() -> Dict[str, Any]:
+    """
+    Return the current allocation policy, see set_allocation_policy.
+    """
+
+    pages, first_touch_threads = store._get_allocation_policy()
+    return {
+        "huge_pages": pages.name,
+        "first_touch_threads": first_touch_threads if first_touch_threads > 1 else None,
+    }
@@ -1,3 +1,4 @@
+import os
 import sys
 from typing import TYPE_CHECKING, Any, Tuple, Union
 
@@ -32,6 +33,7 @@ __all__ = (
     "Ufunc",
     "StdIndex",
     "StrIndex",
+    "PathLike",
 )
 
 
@@ -47,3 +49,5 @@ StdIndex = Union[int, slice, "ellipsis", Tuple[Union[slice, int, "ellipsis"], ..
 StrIndex = Union[
     int, slice, str, "ellipsis", Tuple[Union[slice, int, str, "ellipsis"], ...]
 ]
+
+PathLike = Union[str, "os.PathLike[str]"]
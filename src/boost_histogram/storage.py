@@ -2,11 +2,17 @@ from ._internal.storage import (
     AtomicInt64,
     Double,
     Int64,
+    MappedDouble,
+    MappedInt64,
+    MappedWeight,
     Mean,
+    SharedAtomicInt64,
     Storage,
     Unlimited,
     Weight,
     WeightedMean,
+    get_allocation_policy,
+    set_allocation_policy,
 )
 
 __all__ = (
@@ -18,4 +24,10 @@ __all__ = (
     "Weight",
     "Mean",
     "WeightedMean",
+    "MappedInt64",
+    "MappedDouble",
+    "MappedWeight",
+    "SharedAtomicInt64",
+    "set_allocation_policy",
+    "get_allocation_policy",
 )
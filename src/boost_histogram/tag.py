@@ -1,7 +1,7 @@
 # bh.sum is just the Python sum, so from boost_histogram import * is safe (but
 # not recommended)
 from builtins import sum
-from typing import TypeVar, Union
+from typing import Optional, Sequence, TypeVar, Union
 
 from ._internal.typing import AxisLike
 
@@ -109,12 +109,25 @@ class at:
 
 
 class rebin:
-    __slots__ = ("factor",)
+    """
+    Merge every ``value`` adjacent bins, or the bins between each pair of
+    adjacent ``edges``, which must be edges of the axis. Rebinning onto edges
+    turns the axis into a variable axis.
+    """
 
-    def __init__(self, value: int) -> None:
+    __slots__ = ("factor", "edges")
+
+    def __init__(
+        self, value: Optional[int] = None, *, edges: Optional[Sequence[float]] = None
+    ) -> None:
+        if (value is None) == (edges is None):
+            raise ValueError("Exactly one of a factor and edges is required")
         self.factor = value
+        self.edges = edges
 
     def __repr__(self) -> str:
+        if self.edges is not None:
+            return f"{self.__class__.__name__}(edges={list(self.edges)})"
         return f"{self.__class__.__name__}({self.factor})"
 
     # TODO: Add __call__ to support UHI
@@ -5,8 +5,15 @@
 
 #include <bh_python/pybind11.hpp>
 
+#include <bh_python/select.hpp>
+#include <bh_python/summed_area.hpp>
+
 #include <boost/histogram/algorithm/reduce.hpp>
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 void register_algorithms(py::module& algorithm) {
     py::class_<bh::algorithm::reduce_command>(algorithm, "reduce_command")
         .def(py::init<bh::algorithm::reduce_command>())
@@ -44,6 +51,20 @@ void register_algorithms(py::module& algorithm) {
             return py::str("reduce_command(merge({0}))").format(self.merge);
         });
 
+    py::class_<pick_set_command>(algorithm, "pick_set_command")
+        .def(py::init<pick_set_command>())
+        .def("__repr__", [](const pick_set_command& self) {
+            return py::str("pick_set_command(pick_set(iaxis={0}, indices={1}))")
+                .format(self.iaxis, py::cast(self.indices));
+        });
+
+    py::class_<rebin_edges_command>(algorithm, "rebin_edges_command")
+        .def(py::init<rebin_edges_command>())
+        .def("__repr__", [](const rebin_edges_command& self) {
+            return py::str("rebin_edges_command(rebin_edges(iaxis={0}, edges={1}))")
+                .format(self.iaxis, py::cast(self.edges));
+        });
+
     using slice_mode = bh::algorithm::slice_mode;
 
     py::enum_<slice_mode>(algorithm, "slice_mode")
@@ -212,5 +233,75 @@ void register_algorithms(py::module& algorithm) {
              "end"_a,
              "mode"_a = slice_mode::shrink)
 
+        .def(
+            "pick_set",
+            [](unsigned iaxis, index_list indices) {
+                return pick_set_command{iaxis, std::move(indices)};
+            },
+            "iaxis"_a,
+            "indices"_a,
+            "Pick set option to be used in histogram selections.\n"
+            "\n"
+            "Keeps only the categories at the indices, in that order. The other "
+            "categories\n"
+            "are added to the overflow bin, if the axis has one.\n"
+            "\n"
+            ":param iaxis: which axis to operate on, must be a category axis.\n"
+            ":param indices: indices of the categories that should be kept.")
+
+        .def(
+            "rebin_edges",
+            [](unsigned iaxis, std::vector<double> edges) {
+                return rebin_edges_command{iaxis, std::move(edges)};
+            },
+            "iaxis"_a,
+            "edges"_a,
+            "Rebin onto edges option to be used in reduce() and histogram "
+            "selections.\n"
+            "\n"
+            "Merges the bins between each pair of adjacent edges into one, in a single "
+            "pass.\n"
+            "Bins outside of the edges are added to the flow bins, if the axis has "
+            "them. The\n"
+            "axis becomes a variable axis.\n"
+            "\n"
+            ":param iaxis: which axis to operate on, must have numeric edges.\n"
+            ":param edges: increasing edges, each of which must be an edge of the "
+            "axis.")
+
+        .def("summed_area_table",
+             &summed_area_table<double>,
+             "array"_a.noconvert(),
+             "threads"_a = 0,
+             "Summed-area table of an array in Fortran order, used by "
+             "Histogram.integrate.\n"
+             "\n"
+             "The table has one more entry along each axis, the entry at an index is "
+             "the sum\n"
+             "of the array over all lower indices.")
+        .def("summed_area_table",
+             &summed_area_table<std::uint64_t>,
+             "array"_a.noconvert(),
+             "threads"_a = 0)
+
+        .def("box_sums",
+             &box_sums<double>,
+             "table"_a.noconvert(),
+             "lower"_a,
+             "upper"_a,
+             "threads"_a = 0,
+             "Sums over boxes of bins from a summed-area table.\n"
+             "\n"
+             ":param table: the summed-area table of an array.\n"
+             ":param lower: first index of each box along each axis, shape (n, rank).\n"
+             ":param upper: one past the last index, shape (n, rank).\n"
+             ":param threads: number of threads, 0 for all cores.")
+        .def("box_sums",
+             &box_sums<std::uint64_t>,
+             "table"_a.noconvert(),
+             "lower"_a,
+             "upper"_a,
+             "threads"_a = 0)
+
         ;
 }
@@ -49,4 +49,28 @@ void register_histograms(py::module& hist) {
         hist,
         "any_weighted_mean",
         "N-dimensional histogram for weighted and sampled data with any axis types.");
+
+    register_histogram<storage::mapped_int64>(
+        hist,
+        "any_mapped_int64",
+        "N-dimensional histogram for integer data in a memory-mapped file with any "
+        "axis types.");
+
+    register_histogram<storage::mapped_double>(
+        hist,
+        "any_mapped_double",
+        "N-dimensional histogram for real-valued data in a memory-mapped file with any "
+        "axis types.");
+
+    register_histogram<storage::mapped_weight>(
+        hist,
+        "any_mapped_weight",
+        "N-dimensional histogram for weighted data in a memory-mapped file with any "
+        "axis types.");
+
+    register_histogram<storage::shared_atomic_int64>(
+        hist,
+        "any_shared_atomic_int64",
+        "N-dimensional histogram for threadsafe integer data in shared memory with any "
+        "axis types.");
 }
@@ -5,6 +5,7 @@
 
 #include <bh_python/pybind11.hpp>
 
+#include <bh_python/aligned_allocator.hpp>
 #include <bh_python/register_storage.hpp>
 #include <bh_python/storage.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
@@ -34,4 +35,42 @@ void register_storages(py::module& storage) {
         storage,
         "weighted_mean",
         "Dense storage which tracks means of weighted samples in each cell");
+
+    register_mapped_storage<storage::mapped_int64>(
+        storage, "mapped_int64", "Integer storage in a memory-mapped file");
+
+    register_mapped_storage<storage::mapped_double>(
+        storage, "mapped_double", "Weighted storage in a memory-mapped file");
+
+    register_mapped_storage<storage::mapped_weight>(
+        storage,
+        "mapped_weight",
+        "Weighted storage with a variance estimate in a memory-mapped file");
+
+    register_shared_storage<storage::shared_atomic_int64>(
+        storage,
+        "shared_atomic_int64",
+        "Threadsafe integer storage in shared memory, which other processes can attach "
+        "to by name");
+
+    py::enum_<huge_pages>(storage, "huge_pages")
+        .value("none", huge_pages::none)
+        .value("transparent", huge_pages::transparent)
+        .value("hugetlb", huge_pages::hugetlb);
+
+    storage
+        .def(
+            "_set_allocation_policy",
+            [](huge_pages pages, unsigned first_touch_threads) {
+                auto& policy               = global_allocation_policy();
+                policy.pages               = pages;
+                policy.first_touch_threads = first_touch_threads;
+            },
+            "huge_pages"_a,
+            "first_touch_threads"_a)
+        .def("_get_allocation_policy", []() {
+            const auto& policy = global_allocation_policy();
+            return py::make_tuple(policy.pages.load(),
+                                  policy.first_touch_threads.load());
+        });
 }
@@ -0,0 +1,136 @@
+import threading
+
+import numpy as np
+import pytest
+from numpy.testing import assert_array_equal
+
+import boost_histogram as bh
+
+
+@pytest.fixture(params=[True, False], ids=["mmap", "read"])
+def mmap(request):
+    return request.param
+
+
+@pytest.mark.parametrize(
+    "storage",
+    [
+        bh.storage.Int64,
+        bh.storage.Double,
+        bh.storage.AtomicInt64,
+        bh.storage.Unlimited,
+        bh.storage.Weight,
+        bh.storage.Mean,
+        bh.storage.WeightedMean,
+    ],
+)
+def test_save_load(tmp_path, mmap, storage):
+    h = bh.Histogram(
+        bh.axis.Regular(10, 0, 1, metadata="x"),
+        bh.axis.StrCategory(["a", "b"], growth=True),
+        bh.axis.Variable([1, 2, 4]),
+        storage=storage(),
+        metadata={"name": "h"},
+    )
+    kwargs = {"sample": [3, 4, 5]} if "Mean" in storage.__name__ else {}
+    h.fill([0.1, 0.5, 2], ["a", "c", "b"], [1.5, 3, 3], **kwargs)
+    h.axes[0].label = "first"
+    h.other = 7
+
+    path = tmp_path / "hist.bhist"
+    h.save(path)
+    h2 = bh.Histogram.load(path, mmap=mmap)
+
+    assert h2 == h
+    assert h2.metadata == {"name": "h"}
+    assert h2.other == 7
+    assert h2.axes[0].label == "first"
+    assert h2.axes[0].metadata == "x"
+    assert_array_equal(h2.view(flow=True), h.view(flow=True))
+
+
+def test_save_load_empty(tmp_path, mmap):
+    h = bh.Histogram(bh.axis.StrCategory([], growth=True))
+    path = tmp_path / "hist.bhist"
+    h.save(path)
+    h2 = bh.Histogram.load(path, mmap=mmap)
+
+    assert h2 == h
+    assert h2.view(flow=True).size == 0
+    h2.fill(["a"])
+    assert h2["a"] == 1
+
+
+def test_load_mmap_copy_on_write(tmp_path):
+    h = bh.Histogram(bh.axis.Integer(0, 1000))
+    h.fill(np.arange(1000))
+    path = tmp_path / "hist.bhist"
+    h.save(path)
+
+    h2 = bh.Histogram.load(path)
+    h2.fill(np.arange(1000))
+    assert h2.sum() == 2000
+    assert bh.Histogram.load(path).sum() == 1000
+
+
+@pytest.mark.parametrize("storage", [bh.storage.Double, bh.storage.Unlimited])
+def test_checkpoint_async(tmp_path, storage):
+    h = bh.Histogram(bh.axis.Integer(0, 100), storage=storage())
+    h.fill(np.arange(100))
+    path = tmp_path / "hist.bhist"
+
+    first = h.checkpoint_async(path)
+    h.fill(np.arange(50))
+    first.result()
+    assert bh.Histogram.load(path).sum() == 100
+
+    h.checkpoint_async(path).result()
+    assert bh.Histogram.load(path) == h
+    assert not (tmp_path / "hist.bhist.partial").exists()
+
+
+def test_checkpoint_during_fill(tmp_path):
+    h = bh.Histogram(bh.axis.Integer(0, 1000))
+    values = np.arange(100_000) % 1000
+    path = tmp_path / "hist.bhist"
+
+    def fill():
+        for _ in range(50):
+            h.fill(values)
+
+    thread = threading.Thread(target=fill)
+    thread.start()
+    snapshots = []
+    while thread.is_alive():
+        snapshots.append(h.copy())
+        h.checkpoint_async(path).result()
+        assert bh.Histogram.load(path).sum() % len(values) == 0
+    thread.join()
+
+    for snapshot in snapshots:
+        total = snapshot.sum()
+        assert total % len(values) == 0
+        assert np.all(snapshot.values() == total // len(values) // 1000)
+    assert h.sum() == 50 * len(values)
+
+
+def test_load_subclass(tmp_path):
+    class MyHist(bh.Histogram):
+        pass
+
+    path = tmp_path / "hist.bhist"
+    bh.Histogram(bh.axis.Regular(3, 0, 1)).save(path)
+    assert type(MyHist.load(path)) is MyHist
+
+
+def test_load_invalid(tmp_path):
+    path = tmp_path / "hist.bhist"
+    path.write_bytes(b"not a histogram")
+    with pytest.raises(ValueError):
+        bh.Histogram.load(path)
+
+    h = bh.Histogram(bh.axis.Regular(3, 0, 1))
+    h.save(path)
+    path.write_bytes(path.read_bytes()[:-8])
+    with pytest.raises(ValueError):
+        bh.Histogram.load(path, mmap=False)
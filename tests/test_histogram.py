@@ -70,6 +70,149 @@ def test_copy():
     assert id(b) != id(c)
 
 
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Weight]
+)
+@pytest.mark.parametrize("deep", [True, False])
+def test_copy_on_write(storage, deep):
+    a = bh.Histogram(bh.axis.Integer(0, 3), storage=storage())
+    a.fill([0, 1, 1])
+
+    b = a.copy(deep=deep)
+    b.fill(2)
+    assert a[2] != b[2]
+    assert a[1] == b[1]
+
+    c = a.copy(deep=deep)
+    a.fill(0)
+    assert c[0] != a[0]
+
+
+def test_copy_on_write_views():
+    a = bh.Histogram(bh.axis.Integer(0, 3))
+    view = a.view()
+    b = a.copy()
+    view[0] = 5
+    assert a[0] == 5
+    assert b[0] == 0
+    del view
+
+    c = a.copy()
+    a.view()[1] = 7
+    assert c[1] == 0
+
+    array = np.zeros(5)
+    d = bh.Histogram.from_view([bh.axis.Integer(0, 3)], array)
+    e = d.copy()
+    array[1] = 3
+    assert d[0] == 3
+    assert e[0] == 0
+
+
+def test_copy_on_write_operations():
+    a = bh.Histogram(bh.axis.Integer(0, 3), storage=bh.storage.Double())
+    a.fill([0, 1, 1])
+    expected = a.view(flow=True).copy()
+
+    b = a.copy()
+    version = b._hist._version()
+    b.sum()
+    b._hist.at(1)
+    assert b._hist._version() == version
+
+    for change in (
+        lambda h: h.reset(),
+        lambda h: h.__iadd__(a),
+        lambda h: h.__imul__(a),
+        lambda h: h.__itruediv__(a),
+        lambda h: h._hist._inplace_op("__iadd__", 2),
+        lambda h: h.__setitem__(1, 5),
+        lambda h: h.apply_delta(a.snapshot_delta()._replace(values=np.zeros(5))),
+    ):
+        b = a.copy()
+        version = b._hist._version()
+        change(b)
+        assert b._hist._version() != version
+        assert_array_equal(a.view(flow=True), expected)
+
+
+def test_empty_clone():
+    a = bh.Histogram(bh.axis.Integer(0, 3), storage=bh.storage.Weight())
+    a.fill([0, 1, 1, 5])
+
+    b = a._hist._empty_clone()
+    assert type(b) is type(a._hist)
+    assert b.axis(0) == a._hist.axis(0)
+    assert b.empty(flow=True)
+    assert not a.empty(flow=True)
+
+
+@pytest.mark.parametrize(
+    "storage",
+    [bh.storage.Int64, bh.storage.Double, bh.storage.Mean, bh.storage.Unlimited],
+)
+def test_snapshot_delta(storage):
+    a = bh.Histogram(bh.axis.Integer(0, 200), bh.axis.Integer(0, 2), storage=storage())
+    b = a.copy()
+
+    first = a.snapshot_delta()
+    assert first.shape == (202, 4)
+    assert first.indices is None
+    assert len(first.values) == 202 * 4
+
+    sample = {"sample": [1, 2, 3]} if storage is bh.storage.Mean else {}
+    a.fill([3, 150, 150], [0, 1, 1], **sample)
+    delta = a.snapshot_delta()
+    if hasattr(a._hist, "_take_changes"):
+        assert sorted(delta.indices) == [1 + 3 + 1 * 202, 1 + 150 + 2 * 202]
+        assert len(delta.values) == 2
+
+    assert b.apply_delta(delta) == a
+    if delta.indices is not None:
+        assert len(a.snapshot_delta().indices) == 0
+
+
+def test_snapshot_delta_bulk_changes():
+    a = bh.Histogram(bh.axis.Integer(0, 3))
+    a.snapshot_delta()
+    a.fill(1)
+    a += a
+    assert a.snapshot_delta().indices is None
+
+    a.view()[0] = 2
+    assert a.snapshot_delta().indices is None
+    assert len(a.snapshot_delta().indices) == 0
+
+
+def test_snapshot_delta_records_writes():
+    a = bh.Histogram(bh.axis.Integer(0, 1000))
+    a.snapshot_delta()
+    a.fill([5, 5, 700])
+    a._hist._at_set(0.0, 900)
+    delta = a.snapshot_delta()
+    # cells are recorded when written, also if their contents did not change
+    assert sorted(delta.indices) == [6, 701, 901]
+    assert list(delta.values[np.argsort(delta.indices)]) == [2, 1, 0]
+
+    b = a.copy()
+    a.fill(5)
+    assert list(a.snapshot_delta().indices) == [6]
+    assert b[5] == 2
+
+
+def test_apply_delta_invalid():
+    a = bh.Histogram(bh.axis.Integer(0, 3))
+    b = bh.Histogram(bh.axis.Integer(0, 4))
+    with pytest.raises(ValueError):
+        b.apply_delta(a.snapshot_delta())
+
+    a.snapshot_delta()
+    a.fill(0)
+    delta = a.snapshot_delta()
+    with pytest.raises(IndexError):
+        a.apply_delta(delta._replace(indices=np.array([5], dtype=np.uint64)))
+
+
 def test_fill_int_1d():
 
     h = bh.Histogram(bh.axis.Integer(-1, 2))
@@ -556,6 +699,225 @@ def test_project():
         h.project(2, 1)
 
 
+@pytest.mark.parametrize("storage", [bh.storage.Double, bh.storage.Mean])
+def test_project_many(storage):
+    # large enough to be split between threads
+    h = bh.Histogram(
+        bh.axis.Regular(40, 0, 1),
+        bh.axis.Integer(0, 30),
+        bh.axis.Regular(50, 0, 1, underflow=False),
+        bh.axis.Integer(0, 20, overflow=False),
+        storage=storage(),
+    )
+    size = 5000
+    data = (
+        np.random.uniform(-0.1, 1.1, size=size),
+        np.random.randint(-2, 32, size=size),
+        np.random.uniform(-0.1, 1.1, size=size),
+        np.random.randint(-2, 22, size=size),
+    )
+    mean = storage is bh.storage.Mean
+    sample = {"sample": np.random.normal(size=size)} if mean else {}
+    h.fill(*data, **sample)
+
+    def counts(hist):
+        return hist.counts(flow=True) if mean else hist.values(flow=True)
+
+    subsets = [(0,), (1,), (3,), (2, 0), (1, 3), (0, 1, 2, 3)]
+    for threads in (1, 4):
+        projections = h.project_many(*subsets, threads=threads)
+        for subset, projected in zip(subsets, projections):
+            # a projection keeps the listed order of the axes
+            others = tuple(i for i in range(4) if i not in subset)
+            summed = np.transpose(counts(h), subset + others)
+            summed = summed.sum(axis=tuple(range(len(subset), 4)))
+            assert counts(projected) == approx(summed)
+
+            expected = h.project(*subset)
+            assert projected.axes == expected.axes
+            assert projected.values(flow=True) == approx(expected.values(flow=True))
+
+    # the partial sums of the threads are added in a fixed order
+    first = h.project_many(*subsets, threads=4)
+    for _ in range(3):
+        for projected, expected in zip(h.project_many(*subsets, threads=4), first):
+            assert_array_equal(counts(projected), counts(expected))
+
+    with pytest.raises(ValueError):
+        h.project_many((0,), (0, 0))
+
+
+def test_project_matches_boost_exactly():
+    axes = (bh.axis.Regular(50, 0, 1), bh.axis.Regular(40, 0, 1))
+    data = np.random.uniform(-0.1, 1.1, size=(2, 10000))
+    weight = np.random.exponential(1e6, size=10000)
+    dense = bh.Histogram(*axes, storage=bh.storage.Double())
+    dense.fill(*data, weight=weight)
+    # unlimited storages are projected by Boost.Histogram
+    other = bh.Histogram(*axes, storage=bh.storage.Unlimited())
+    other.fill(*data, weight=weight)
+
+    for subset in ((0,), (1,)):
+        (projected,) = dense.project_many(subset, threads=1)
+        expected = other.project(*subset)
+        assert_array_equal(projected.values(flow=True), expected.values(flow=True))
+
+
+@pytest.mark.parametrize(
+    "storage",
+    [bh.storage.Int64, bh.storage.Double, bh.storage.Weight, bh.storage.Unlimited],
+)
+def test_integrate(storage):
+    h = bh.Histogram(
+        bh.axis.Regular(30, 0, 1),
+        bh.axis.Integer(0, 20, underflow=False),
+        bh.axis.Regular(10, 0, 1, overflow=False),
+        storage=storage(),
+    )
+    size = 2000
+    weighted = storage in {bh.storage.Double, bh.storage.Weight}
+    weight = {"weight": np.random.uniform(0.5, 2, size=size)} if weighted else {}
+    h.fill(
+        np.random.uniform(-0.1, 1.1, size=size),
+        np.random.randint(-2, 22, size=size),
+        np.random.uniform(-0.1, 1.1, size=size),
+        **weight,
+    )
+    values = h.values(flow=True)
+    underflow = (1, 0, 1)
+
+    def expected(lower, upper):
+        box = tuple(
+            slice(max(lo + u, 0), max(hi + u, 0))
+            for lo, hi, u in zip(lower, upper, underflow)
+        )
+        return values[box].sum()
+
+    boxes = [
+        ((0, 0, 0), (30, 20, 10)),
+        ((-1, -1, -1), (31, 21, 11)),
+        ((3, 5, 2), (17, 6, 9)),
+        ((5, 2, 1), (5, 10, 4)),
+        ((-5, 0, 0), (100, 100, 100)),
+    ]
+    for lower, upper in boxes:
+        result = h.integrate(lower, upper)
+        if storage is bh.storage.Weight:
+            result = result.value
+        assert result == approx(expected(lower, upper))
+
+    lower = np.array([b[0] for b in boxes])
+    upper = np.array([b[1] for b in boxes])
+    result = h.integrate(lower, upper, threads=2)
+    if storage is bh.storage.Weight:
+        assert result.variance == approx(
+            [h.integrate(lo, hi).variance for lo, hi in boxes]
+        )
+        result = result.value
+    assert result == approx([expected(lo, hi) for lo, hi in boxes])
+
+    # the table is rebuilt after filling
+    h.fill(0.5, 3, 0.5)
+    values = h.values(flow=True)
+    result = h.integrate(*boxes[1])
+    if storage is bh.storage.Weight:
+        result = result.value
+    assert result == approx(values.sum())
+
+    with pytest.raises(ValueError):
+        h.integrate((0, 0), (1, 1))
+
+
+def test_integrate_small_box_next_to_large_total():
+    h = bh.Histogram(bh.axis.Integer(0, 4), bh.axis.Integer(0, 4))
+    h.fill(0, 0, weight=2.0 ** 52)
+    h.fill(2, 2)
+    # the corners of the box add up to twice the large bin
+    assert h.integrate([1, 1], [3, 3]) == 1
+    assert h.integrate([0, 0], [3, 3]) == 2.0 ** 52 + 1
+
+
+def test_integrate_invalid():
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1), storage=bh.storage.Mean())
+    with pytest.raises(TypeError):
+        h.integrate((0,), (10,))
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Weight]
+)
+def test_cached_results_follow_changes(storage):
+    h = bh.Histogram(
+        bh.axis.Regular(10, 0, 1), bh.axis.Integer(0, 5), storage=storage()
+    )
+    assert h.empty()
+
+    def total(hist):
+        result = hist.sum(flow=True)
+        return result.value if storage is bh.storage.Weight else result
+
+    def cell(value):
+        return (value, value) if storage is bh.storage.Weight else value
+
+    def check(expected):
+        assert total(h) == approx(expected)
+        assert total(h.project(0)) == approx(expected)
+        assert total(h) == approx(expected)
+
+    h.fill([0.5, 0.7], [1, 2])
+    assert not h.empty()
+    check(2)
+
+    # results are not shared with the caller
+    h.project(0)[0] = cell(5)
+    check(2)
+
+    h[3, 1] = cell(4)
+    check(6)
+
+    h += h
+    check(12)
+
+    h *= 2
+    check(24)
+
+    view = h.view(flow=True)
+    view[0, 0] = cell(1)
+    check(25)
+    view[0, 0] = cell(2)
+    check(26)
+    del view
+    check(26)
+
+    h.reset()
+    check(0)
+    assert h.empty()
+
+
+def test_cached_profile_variances():
+    h = bh.Histogram(bh.axis.Regular(4, 0, 1), storage=bh.storage.Mean())
+    h.fill([0.1, 0.1, 0.6], sample=[1, 3, 2])
+    variances = h.variances()
+    assert variances[0] == approx(1)
+    variances[0] = 7
+    assert h.variances()[0] == approx(1)
+
+    h.fill(0.1, sample=5)
+    assert h.variances()[0] == approx(4 / 3)
+
+
+def test_cached_centers_grow():
+    ax = bh.axis.Integer(0, 3, growth=True)
+    h = bh.Histogram(ax)
+    centers = h.axes[0].centers
+    assert centers == approx([0.5, 1.5, 2.5])
+    centers[0] = 7
+    assert h.axes[0].centers == approx([0.5, 1.5, 2.5])
+
+    h.fill(4)
+    assert h.axes[0].centers == approx([0.5, 1.5, 2.5, 3.5, 4.5])
+
+
 def test_shrink_1d():
     h = bh.Histogram(bh.axis.Regular(20, 1, 5))
     h.fill(1.1)
@@ -602,6 +964,45 @@ def test_rebin_nd():
     assert h[{1: bh.sum}].axes.size == (20, 40)
 
 
+@pytest.mark.parametrize("storage", [bh.storage.Int64, bh.storage.Weight])
+def test_reduce_dense_matches_unlimited(storage):
+    # large enough to be split between threads; unlimited storage is reduced serially
+    axes = (
+        bh.axis.Regular(60, 0, 1),
+        bh.axis.Variable(np.linspace(0, 1, 41)),
+        bh.axis.Integer(0, 300),
+    )
+    dense = bh.Histogram(*axes, storage=storage())
+    data = (
+        np.random.uniform(-0.1, 1.1, size=20000),
+        np.random.uniform(-0.1, 1.1, size=20000),
+        np.random.randint(-5, 305, size=20000),
+    )
+    dense.fill(*data)
+    unlimited = bh.Histogram(*axes, storage=bh.storage.Unlimited())
+    unlimited.fill(*data)
+
+    algorithm = bh._core.algorithm
+    commands = [
+        (algorithm.rebin(0, 3),),
+        (algorithm.shrink(1, 0.2, 0.65), algorithm.rebin(1, 2)),
+        (algorithm.crop_and_rebin(0, 0.1, 0.9, 2), algorithm.slice(2, 10, 200)),
+        (algorithm.rebin(2), algorithm.rebin(4), algorithm.rebin(5)),
+    ]
+    for args in commands:
+        expected = unlimited._hist.reduce(*args)
+        reduced = dense._hist.reduce(*args)
+        assert reduced.rank() == expected.rank()
+        for i in range(reduced.rank()):
+            assert reduced.axis(i) == expected.axis(i)
+        assert_array_equal(
+            np.asarray(reduced.view(flow=True))["value"]
+            if storage is bh.storage.Weight
+            else reduced.view(flow=True),
+            expected.view(flow=True),
+        )
+
+
 # CLASSIC: This used to have metadata too, but that does not compare equal
 def test_pickle_0():
     a = bh.Histogram(
@@ -1190,6 +1591,115 @@ def test_add_broadcast():
     assert h5.sum(flow=True) == 12 * 22
 
 
+def test_inplace_weight_variances():
+    h = bh.Histogram(
+        bh.axis.Regular(4, 0, 1), bh.axis.Integer(0, 3), storage=bh.storage.Weight()
+    )
+    h.fill(np.random.uniform(-0.2, 1.2, 500), np.random.randint(-1, 4, 500))
+    before = h.view(flow=True).copy()
+
+    factor = np.arange(1, 5, dtype=float).reshape(4, 1)
+    h /= factor
+    after = h.view(flow=False)
+    assert after.value == approx(before.value[1:-1, 1:-1] / factor)
+    assert after.variance == approx(before.variance[1:-1, 1:-1] / factor ** 2)
+    # flow bins are untouched by an array without flow bins
+    assert h.view(flow=True).value[0] == approx(before.value[0])
+
+    h *= np.full((6, 5), 2.0)
+    assert h.view(flow=True).value[0] == approx(2 * before.value[0])
+    assert h.view(flow=True).variance[0] == approx(4 * before.variance[0])
+
+    h2 = h.copy()
+    h2 += h.view(flow=False)
+    assert h2.view().value == approx(2 * h.view().value)
+    assert h2.view().variance == approx(2 * h.view().variance)
+
+    h3 = h + 1.5
+    assert h3.view(flow=True).value == approx(h.view(flow=True).value + 1.5)
+    assert h3.view(flow=True).variance == approx(h.view(flow=True).variance + 2.25)
+
+    with pytest.raises(TypeError):
+        h *= h.view()
+
+
+@pytest.mark.parametrize("storage", [bh.storage.Int64, bh.storage.AtomicInt64])
+def test_inplace_integer_storage(storage):
+    h = bh.Histogram(bh.axis.Integer(0, 3), storage=storage())
+    h.fill([0, 1, 1, 2])
+    h *= 3
+    h += np.array([1, 2, 3])
+    assert_array_equal(h.view(), [4, 8, 6])
+    assert_array_equal(h.view(flow=True), [0, 4, 8, 6, 0])
+    h += [1]
+    assert_array_equal(h.view(flow=True), [1, 5, 9, 7, 1])
+
+    with pytest.raises(TypeError):
+        h /= 2
+    with pytest.raises(TypeError):
+        h *= 1.5
+
+    # negative operands would wrap around to huge counts
+    with pytest.raises(ValueError):
+        h *= -1
+    with pytest.raises(ValueError):
+        h += [-5]
+    with pytest.raises(ValueError):
+        h += np.array([1, -1, 1])
+    assert_array_equal(h.view(flow=True), [1, 5, 9, 7, 1])
+
+
+def test_inplace_mean_storage():
+    h = bh.Histogram(bh.axis.Integer(0, 3), storage=bh.storage.Mean())
+    with pytest.raises(TypeError):
+        h *= 2
+
+
+@pytest.mark.parametrize("storage", [bh.storage.Double, bh.storage.Weight])
+@pytest.mark.parametrize("threads", [None, 2])
+def test_lazy_scale(storage, threads):
+    lazy = bh.Histogram(bh.axis.Regular(5, 0, 1), storage=storage())
+    eager = bh.Histogram(bh.axis.Regular(5, 0, 1), storage=storage())
+
+    for step in range(20):
+        x = np.random.uniform(-0.2, 1.2, 100)
+        w = np.random.uniform(0.5, 2.0, 100)
+        lazy.fill(x, threads=threads)
+        lazy.fill(x, weight=w, threads=threads)
+        lazy *= 0.9
+        lazy /= 1 + step % 3
+        eager.fill(x)
+        eager.fill(x, weight=w)
+        eager._hist._inplace_op("__imul__", 0.9 / (1 + step % 3))
+
+    assert lazy.values(flow=True) == approx(eager.values(flow=True))
+    if storage is bh.storage.Weight:
+        assert lazy.variances(flow=True) == approx(eager.variances(flow=True))
+
+    # sums, projections and copies carry the pending factor over
+    lazy *= 2
+    assert not lazy.empty()
+    total, expected = lazy.sum(flow=True), eager.sum(flow=True)
+    if storage is bh.storage.Weight:
+        assert total.value == approx(2 * expected.value)
+        assert total.variance == approx(4 * expected.variance)
+    else:
+        assert total == approx(2 * expected)
+    projected = lazy.project(0)
+    assert lazy._scale != 1.0
+    assert projected.values(flow=True) == approx(2 * eager.values(flow=True))
+
+    # anything else applies the pending factor first
+    assert lazy.copy().values(flow=True) == approx(2 * eager.values(flow=True))
+    lazy *= 0.5
+    assert pickle.loads(pickle.dumps(lazy)) == lazy
+
+    lazy *= 3
+    lazy.reset()
+    lazy.fill([0.5])
+    assert lazy.values() == approx([0, 0, 1, 0, 0])
+
+
 # Issue #431
 def test_mul_shallow():
     import threading
@@ -1240,3 +1750,59 @@ def test_sum_empty_axis():
     )
     assert hist.sum().value == 0
     assert "Str" in repr(hist)
+
+
+def test_from_view_adopts_memory():
+    axes = [bh.axis.Regular(4, 0, 1), bh.axis.Integer(0, 3)]
+    view = np.asfortranarray(np.arange(6 * 5, dtype=float).reshape(6, 5))
+
+    h = bh.Histogram.from_view(axes, view, metadata="hi")
+    assert h._storage_type is bh.storage.Double
+    assert h.metadata == "hi"
+    assert_array_equal(h.view(flow=True), view)
+
+    h.fill(0.1, 1)
+    assert view[1, 2] == 8
+    view[0, 0] = 42
+    assert h.view(flow=True)[0, 0] == 42
+
+
+@pytest.mark.parametrize(
+    "view",
+    [
+        np.arange(6 * 5, dtype=float).reshape(6, 5),
+        np.asfortranarray(np.arange(6 * 5, dtype=np.int32).reshape(6, 5)),
+    ],
+    ids=["c_order", "int32"],
+)
+def test_from_view_copies(view):
+    axes = [bh.axis.Regular(4, 0, 1), bh.axis.Integer(0, 3)]
+    h = bh.Histogram.from_view(axes, view)
+    assert_array_equal(h.view(flow=True), view)
+
+    h.reset()
+    assert view.sum() == 435
+
+
+def test_from_view_storages():
+    orig = bh.Histogram(bh.axis.Regular(3, 0, 1), storage=bh.storage.Weight())
+    orig.fill([0.1, 0.5, 2], weight=[1, 2, 3])
+    h = bh.Histogram.from_view(orig.axes, orig.view(flow=True))
+    assert h._storage_type is bh.storage.Weight
+    assert h == orig
+
+    h = bh.Histogram.from_view(
+        [bh.axis.Integer(0, 2)], [0, 1, 2, 3], storage=bh.storage.Unlimited()
+    )
+    assert_array_equal(h.view(flow=True), [0, 1, 2, 3])
+
+
+def test_from_view_wrong_shape():
+    with pytest.raises(ValueError):
+        bh.Histogram.from_view([bh.axis.Regular(4, 0, 1)], np.zeros(4))
+    with pytest.raises(ValueError):
+        bh.Histogram.from_view([bh.axis.Regular(4, 0, 1)], np.zeros((6, 1)))
+    with pytest.raises(ValueError):
+        bh.Histogram.from_view(
+            [bh.axis.Regular(4, 0, 1)], np.zeros(4), storage=bh.storage.Unlimited()
+        )
@@ -455,3 +455,152 @@ def test_add_flowbins():
     scale_value = (h + 5).values(flow=True)
 
     assert scale_value == approx(ref_value)
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Unlimited]
+)
+def test_select_one_pass(storage):
+    h = bh.Histogram(
+        bh.axis.Regular(10, 0, 10),
+        bh.axis.Integer(0, 10, underflow=False, overflow=False),
+        bh.axis.StrCategory(["a", "b", "c"]),
+        storage=storage(),
+    )
+    h.fill(
+        np.random.uniform(-2, 12, size=2000),
+        np.random.randint(0, 10, size=2000),
+        np.random.choice(["a", "b", "c", "d"], size=2000),
+    )
+    vals = h.values(flow=True)
+
+    assert_array_equal(h[:, 3, ::sum].values(flow=True), vals[:, 3, :].sum(axis=1))
+    assert_array_equal(h[::sum, 2:5, 1].values(flow=True), vals[:, 2:5, 1].sum(axis=0))
+    assert h[::sum, ::sum, ::sum] == approx(vals.sum())
+    assert h[1:3:sum, 3, 0] == approx(vals[2:4, 3, 0].sum())
+
+    # removed bins are collected in the flow bins of the rebinned axis
+    rebinned = h[2:8:bh.rebin(2), 3, ::sum]
+    summed = vals[:, 3, :].sum(axis=1)
+    expected = [summed[:3].sum(), *summed[3:9].reshape(3, 2).sum(axis=1)]
+    assert_array_equal(rebinned.values(flow=True), expected + [summed[9:].sum()])
+    assert rebinned.axes[0] == bh.axis.Regular(3, 2, 8)
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Weight, bh.storage.Unlimited]
+)
+def test_rebin_edges(storage):
+    h = bh.Histogram(
+        bh.axis.Regular(10, 0, 1, metadata="x"),
+        bh.axis.Integer(0, 6, underflow=False, overflow=False),
+        storage=storage(),
+    )
+    h.fill(np.random.uniform(-0.2, 1.2, 1000), np.random.randint(0, 6, 1000))
+    vals = h.values(flow=True)
+
+    rebinned = h[bh.rebin(edges=[0.2, 0.3, 0.6, 1.0]), :]
+    assert rebinned.axes[0] == bh.axis.Variable([0.2, 0.3, 0.6, 1.0], metadata="x")
+    groups = [vals[:3], vals[3:4], vals[4:7], vals[7:11], vals[11:]]
+    expected = np.stack([g.sum(axis=0) for g in groups])
+    assert rebinned.values(flow=True) == approx(expected)
+
+    # bins outside of the edges are dropped without flow bins
+    rebinned = h[:, bh.rebin(edges=[1, 3, 4])]
+    assert rebinned.axes[1] == bh.axis.Variable(
+        [1, 3, 4], underflow=False, overflow=False
+    )
+    expected = np.stack([vals[:, 1:3].sum(axis=1), vals[:, 3]], axis=1)
+    assert rebinned.values(flow=True) == approx(expected)
+
+    reduced = h._reduce(bh._core.algorithm.rebin_edges(1, [1.0, 3.0, 4.0]))
+    assert reduced == rebinned
+
+
+def test_rebin_edges_invalid():
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1), bh.axis.StrCategory(["a", "b"]))
+
+    with pytest.raises(ValueError):
+        h[bh.rebin(edges=[0.2, 0.25]), :]
+    with pytest.raises(ValueError):
+        h[bh.rebin(edges=[0.5, 0.2]), :]
+    with pytest.raises(ValueError):
+        h[:, bh.rebin(edges=[0, 1])]
+    with pytest.raises(IndexError):
+        h[2:5 : bh.rebin(edges=[0.2, 0.4]), :]
+    with pytest.raises(ValueError):
+        bh.rebin(2, edges=[0, 1])
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Weight, bh.storage.Mean]
+)
+def test_slice_shares_cells(storage):
+    h = bh.Histogram(
+        bh.axis.Regular(20, 0, 2), bh.axis.Integer(0, 4), storage=storage()
+    )
+    sample = {"sample": np.ones(500)} if storage is bh.storage.Mean else {}
+    h.fill(np.random.uniform(-0.5, 2.5, 500), np.random.randint(-1, 5, 500), **sample)
+
+    values = np.array(h.values()[5:15, 1:])
+    counts = np.array(h.counts()[5:15, 1:])
+
+    v = h[5:15, 1:]
+    assert v._window is not None
+    assert v.axes[0] == bh.axis.Regular(10, 0.5, 1.5)
+    assert v.axes[1] == bh.axis.Integer(1, 4)
+    total = v.sum(flow=True)
+    projected = v.project(1, 0)
+    inner = None if storage is bh.storage.Mean else v.sum()
+    assert v._window is not None
+
+    # the histogram it was taken from copies its cells when changed
+    h.fill([1.0], [2], **({"sample": [1.0]} if sample else {}))
+    assert v._window is not None
+    assert_array_equal(v.values(), values)
+    assert v._window is None
+
+    copied = v.copy()
+    assert_array_equal(copied.values(), values)
+    assert_array_equal(copied.counts(), counts)
+    assert copied.project(1, 0) == projected
+    assert copied.sum(flow=True) == total
+    if inner is not None:
+        assert copied.sum() == inner
+
+    v.fill([1.0], [2], **({"sample": [1.0]} if sample else {}))
+    assert v.view().flags.writeable
+    assert v != copied
+    assert h[5:15:bh.rebin(5), :]._window is None
+
+
+def test_slice_view_is_writable():
+    h = bh.Histogram(bh.axis.Integer(0, 10))
+    h.fill(np.arange(10))
+
+    h2 = h[2:5]
+    h2.view()[...] = 7
+    assert_array_equal(h2.values(), [7, 7, 7])
+    assert h[3] == 1
+
+    h3 = h[2:5]
+    h3.values()
+    view = h3.view()
+    view[0] = 5
+    assert h3[0] == 5
+    assert h[2] == 1
+
+    h4 = h[2:5]
+    h4.values()[0] = 9
+    assert h4[0] == 9
+    assert h[2] == 1
+
+
+def test_small_slice_is_copied():
+    h = bh.Histogram(bh.axis.Integer(0, 100))
+    h.fill(np.arange(100))
+
+    # sharing would keep all cells alive and copy them on the next fill of h
+    part = h[2:5]
+    assert part._window is None
+    assert_array_equal(part.values(), [1, 1, 1])
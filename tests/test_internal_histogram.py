@@ -186,6 +186,69 @@ def test_numpy_flow():
     assert_array_equal(view_flow_default, view_flow_false)
 
 
+@pytest.mark.parametrize("flow", [True, False])
+def test_numpy_no_copy(flow):
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1), bh.axis.Integer(0, 5))
+    h.fill([0.5, 0.7], [1, 2])
+
+    values, *_ = h._hist.to_numpy(flow)
+    assert np.shares_memory(values, h.view(flow=True))
+    assert_array_equal(values, h.view(flow=flow))
+
+    values, *_ = h.to_numpy(flow)
+    assert np.shares_memory(values, h.view(flow=True))
+
+
+@pytest.mark.skipif(not hasattr(np, "from_dlpack"), reason="needs NumPy 1.22")
+@pytest.mark.parametrize("storage", [bh.storage.Double, bh.storage.Weight])
+def test_dlpack(storage):
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1), storage=storage())
+    h.fill([0.5, 0.7])
+
+    values = np.from_dlpack(h)
+    assert_array_equal(values, h.values())
+    del h
+    assert values.sum() == 2
+
+
+@pytest.mark.skipif(not hasattr(np, "from_dlpack"), reason="needs NumPy 1.22")
+def test_dlpack_slice():
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1))
+    h.fill([0.25, 0.35, 0.75])
+
+    part = h[2:5]
+    values = np.from_dlpack(part)
+    assert_array_equal(values, [1, 1, 0])
+    part.fill(0.25)
+    assert_array_equal(values, [2, 1, 0])
+    assert h[2] == 1
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Weight, bh.storage.AtomicInt64]
+)
+def test_arrow_export(storage):
+    h = bh.Histogram(bh.axis.Regular(3, 0, 1), bh.axis.Integer(0, 2), storage=storage())
+    h.fill([0.5, 0.7, 2], [1, 1, 0])
+
+    schema, array = h.__arrow_c_array__()
+    assert type(schema).__name__ == "PyCapsule"
+    assert type(array).__name__ == "PyCapsule"
+    del schema, array
+
+    pa = pytest.importorskip("pyarrow")
+    batch = pa.record_batch(h)
+    h.fill([0.5], [0])
+
+    extent = h.axes.extent
+    assert batch.num_rows == extent[0] * extent[1]
+    assert batch.column("bin0").to_pylist()[:5] == [-1, 0, 1, 2, 3]
+    assert batch.column("bin1").to_pylist()[:: extent[0]] == [-1, 0, 1, 2]
+    values = np.array(h.values(flow=True)).reshape(-1, order="F")
+    values[2 + 1 * extent[0]] -= 1  # the fill after the export is not seen
+    assert batch.column("value").to_pylist() == values.tolist()
+
+
 def test_numpy_compare():
     h = bh.Histogram(
         bh.axis.Regular(10, 0, 1), bh.axis.Regular(5, 0, 1), storage=bh.storage.Int64()
@@ -261,7 +324,6 @@ def test_int_cat_hist():
         h.fill(0.5)
 
 
-@pytest.mark.filterwarnings("ignore:List indexing selection is experimental")
 def test_int_cat_hist_pick_several():
     h = bh.Histogram(
         bh.axis.IntCategory([1, 2, 7], __dict__={"xval": 5}), storage=bh.storage.Int64()
@@ -291,7 +353,6 @@ def test_int_cat_hist_pick_several():
     assert h[[0, 1, 2]].axes[0].xval == 5
 
 
-@pytest.mark.filterwarnings("ignore:List indexing selection is experimental")
 def test_str_cat_pick_several():
     h = bh.Histogram(bh.axis.StrCategory(["a", "b", "c"]))
 
@@ -312,7 +373,27 @@ def test_str_cat_pick_several():
     assert tuple(h[[1, 0]].axes[0]) == ("b", "a")
 
 
-@pytest.mark.filterwarnings("ignore:List indexing selection is experimental")
+def test_pick_several_overflow():
+    h = bh.Histogram(bh.axis.IntCategory([1, 2, 7, 9]), bh.axis.Regular(2, 0, 1))
+    h.fill([1, 2, 2, 7, 9, 9, 9, 11], 0.25)
+
+    picked = h[[2, 0], :]
+    assert picked.values(flow=True)[:, 1] == approx([1, 1, 6])
+    assert picked.sum(flow=True) == h.sum(flow=True)
+    assert repr(bh._core.algorithm.pick_set(0, [2, 0])) == (
+        "pick_set_command(pick_set(iaxis=0, indices=[2, 0]))"
+    )
+
+    growing = bh.Histogram(bh.axis.StrCategory(["a", "b"], growth=True))
+    growing.fill(["a", "b", "b"])
+    assert growing[[1]].values(flow=True) == approx([2])
+
+    with pytest.raises(ValueError):
+        h[[0, 0], :]
+    with pytest.raises(IndexError):
+        h[[0, 4], :]
+
+
 def test_pick_invalid():
     h = bh.Histogram(bh.axis.Regular(10, 0, 1))
     with pytest.raises(RuntimeError):
@@ -323,7 +404,6 @@ def test_pick_invalid():
         h[[0, 1]]
 
 
-@pytest.mark.filterwarnings("ignore:List indexing selection is experimental")
 def test_str_cat_pick_dual():
     h = bh.Histogram(
         bh.axis.StrCategory(["a", "b", "c"]), bh.axis.StrCategory(["d", "e", "f"])
@@ -339,7 +419,6 @@ def test_str_cat_pick_dual():
     assert h[[0, 1], [2, 1]].values() == approx(vals[[0, 1]][:, [2, 1]])
 
 
-@pytest.mark.filterwarnings("ignore:List indexing selection is experimental")
 def test_pick_multiaxis():
     h = bh.Histogram(
         bh.axis.StrCategory(["a", "b", "c"]),
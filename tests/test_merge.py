@@ -0,0 +1,94 @@
+import pickle
+
+import numpy as np
+import pytest
+from numpy.testing import assert_array_equal
+
+import boost_histogram as bh
+
+
+def write_parts(tmp_path, parts, storage=bh.storage.Double):
+    paths = []
+    total = bh.Histogram(bh.axis.Regular(20, 0, 1), storage=storage())
+    for i in range(parts):
+        h = total.copy()
+        h.reset()
+        h.fill(np.random.uniform(size=100))
+        total += h
+
+        path = tmp_path / f"part{i}.bin"
+        if i % 2:
+            h.save(path)
+        else:
+            path.write_bytes(pickle.dumps(h, protocol=pickle.HIGHEST_PROTOCOL))
+        paths.append(path)
+    return paths, total
+
+
+@pytest.mark.parametrize("threads", [1, 3])
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Weight]
+)
+def test_merge_files(tmp_path, threads, storage):
+    paths, total = write_parts(tmp_path, 11, storage)
+
+    merged = bh.merge_files(paths, threads=threads)
+    assert_array_equal(merged.view(flow=True), total.view(flow=True))
+    assert merged.axes == total.axes
+
+
+def test_merge_files_unlimited(tmp_path):
+    paths, total = write_parts(tmp_path, 4, bh.storage.Unlimited)
+    assert bh.merge_files(paths, threads=2) == total
+
+
+def test_merge_files_invalid(tmp_path):
+    with pytest.raises(ValueError):
+        bh.merge_files([])
+
+    paths, _ = write_parts(tmp_path, 2)
+    other = tmp_path / "other.bin"
+    bh.Histogram(bh.axis.Regular(3, 0, 1)).save(other)
+    with pytest.raises(ValueError):
+        bh.merge_files(paths + [other], threads=1)
+
+    not_a_histogram = tmp_path / "list.pkl"
+    not_a_histogram.write_bytes(pickle.dumps([1, 2]))
+    with pytest.raises(TypeError):
+        bh.merge_files(paths + [not_a_histogram], threads=2)
+
+
+@pytest.mark.parametrize("threads", [None, 1, 4])
+@pytest.mark.parametrize(
+    "storage",
+    [bh.storage.Int64, bh.storage.Double, bh.storage.Mean, bh.storage.Unlimited],
+)
+def test_sum_histograms(threads, storage):
+    # large enough to be split between threads
+    axes = (bh.axis.Regular(300, 0, 1), bh.axis.Integer(0, 300))
+    h = bh.Histogram(*axes, storage=storage(), metadata="first")
+    sample = {"sample": np.ones(1000)} if storage is bh.storage.Mean else {}
+    hists = []
+    for _ in range(7):
+        part = h.copy()
+        part.fill(np.random.uniform(size=1000), np.arange(1000) % 300, **sample)
+        hists.append(part)
+
+    total = bh.sum_histograms(hists, threads=threads)
+    expected = hists[0].copy()
+    for part in hists[1:]:
+        expected += part
+    assert total == expected
+    assert total.metadata == "first"
+    assert hists[0] != total
+
+
+def test_sum_histograms_invalid():
+    with pytest.raises(ValueError):
+        bh.sum_histograms([])
+
+    a = bh.Histogram(bh.axis.Regular(10, 0, 1))
+    with pytest.raises(ValueError):
+        bh.sum_histograms([a, bh.Histogram(bh.axis.Regular(11, 0, 1))])
+    with pytest.raises(TypeError):
+        bh.sum_histograms([a, bh.Histogram(*a.axes, storage=bh.storage.Int64())])
@@ -1,6 +1,7 @@
 import copy
 import ctypes
 import math
+import pickle
 from pickle import dumps, loads
 
 import env
@@ -283,3 +284,106 @@ def test_cloudpickle():
 
     assert h == h2
     assert h is not h2
+
+
+@pytest.mark.skipif(pickle.HIGHEST_PROTOCOL < 5, reason="requires pickle protocol 5")
+@pytest.mark.parametrize(
+    "storage, kwargs",
+    [
+        (bh.storage.Int64, {}),
+        (bh.storage.Double, {}),
+        (bh.storage.Weight, {"weight": 2}),
+        (bh.storage.Mean, {"sample": 3}),
+    ],
+)
+def test_out_of_band_buffers(storage, kwargs):
+    n = 10000
+    hist = bh.Histogram(bh.axis.Integer(0, n), storage=storage())
+    hist.fill(np.arange(-1, n + 1), **{k: np.full(n + 2, v) for k, v in kwargs.items()})
+
+    buffers = []
+    data = dumps(hist, protocol=5, buffer_callback=buffers.append)
+    assert len(buffers) == 1
+    assert buffers[0].raw().nbytes == hist.view(flow=True).nbytes
+    assert len(data) < buffers[0].raw().nbytes
+
+    # the pickled buffer is a snapshot, later fills do not change it
+    hist.fill([5], **{k: [v] for k, v in kwargs.items()})
+    new = loads(data, buffers=buffers)
+    assert new != hist
+    new.fill([5], **{k: [v] for k, v in kwargs.items()})
+    assert new == hist
+
+    # loaded histograms copy the buffer on the first write
+    again = loads(data, buffers=buffers)
+    again.reset()
+    assert not loads(data, buffers=buffers).empty(flow=True)
+
+
+def test_many_categories(copy_fn):
+    categories = [f"cat{i}" for i in range(20000)]
+    hist = bh.Histogram(bh.axis.StrCategory(categories), bh.axis.IntCategory(range(50)))
+    hist.fill(["cat3", "cat19999"], [0, 49])
+
+    new = copy_fn(hist)
+    assert new == hist
+    assert list(new.axes[0]) == categories
+
+
+@pytest.mark.parametrize(
+    "categories",
+    [[], ["", "α", "日本語", "a\x00b", "x" * 1000]],
+    ids=["empty", "mixed"],
+)
+def test_str_category_values(copy_fn, categories):
+    axis = bh.axis.StrCategory(categories, growth=True)
+    new = copy_fn(axis)
+    assert new == axis
+    assert list(new) == categories
+
+
+@pytest.mark.parametrize(
+    "storage", [bh.storage.Int64, bh.storage.Double, bh.storage.Weight, bh.storage.Mean]
+)
+@pytest.mark.parametrize("layout", ["runs", "sparse"])
+def test_mostly_empty_storage(storage, layout):
+    n = 100000
+    hist = bh.Histogram(bh.axis.Integer(0, n), storage=storage())
+    if layout == "runs":
+        x = np.concatenate([np.arange(10, 500), np.arange(n - 300, n + 1)])
+    else:
+        x = np.arange(-1, n, 997)
+    kwargs = {"sample": np.ones_like(x)} if storage is bh.storage.Mean else {}
+    hist.fill(x, **kwargs)
+
+    data = dumps(hist, -1)
+    assert len(data) < hist.view(flow=True).nbytes // 10
+
+    new = loads(data)
+    assert new == hist
+    assert_array_equal(new.view(flow=True), hist.view(flow=True))
+
+    new.fill(5, **{k: [1] for k in kwargs})
+    assert new != hist
+
+
+@pytest.mark.parametrize("storage", [bh.storage.Int64, bh.storage.Weight])
+def test_small_storage_stays_dense(storage):
+    # the only layout that older releases can read
+    hist = bh.Histogram(bh.axis.Integer(0, 1000), storage=storage())
+    hist.fill(5)
+    state = hist._hist.__getstate__()
+    assert any(isinstance(x, np.ndarray) and x.size >= 1002 for x in state)
+
+
+def test_str_category_version():
+    # string categories are saved packed, which older releases must refuse
+    axis = bh.axis.StrCategory(["a", "b"])
+    state = axis._ax.__getstate__()
+    assert state[0] == 1
+    assert bh.Histogram(axis).__getstate__()[0] == 1
+    assert bh.Histogram(bh.axis.IntCategory([1, 2])).__getstate__()[0] == 0
+
+    cpp_axis = type(axis._ax).__new__(type(axis._ax))
+    with pytest.raises(ValueError):
+        cpp_axis.__setstate__((2,) + state[1:])
@@ -1,3 +1,8 @@
+import multiprocessing
+import pickle
+import uuid
+
+import env
 import numpy as np
 import pytest
 from numpy.testing import assert_array_equal
@@ -258,3 +263,115 @@ def test_summing_weighted_mean_storage():
     assert s1.sum_of_weights == approx(s2.sum_of_weights)
     assert s1.sum_of_weights_squared == approx(s2.sum_of_weights_squared)
     assert s1.variance == approx(s2.variance)
+
+
+@pytest.mark.skipif(env.WIN, reason="File-backed storages require mmap")
+@pytest.mark.parametrize(
+    "storage",
+    [bh.storage.MappedInt64, bh.storage.MappedDouble, bh.storage.MappedWeight],
+)
+def test_mapped_storage(tmp_path, storage):
+    path = str(tmp_path / "hist.bin")
+
+    h = bh.Histogram(bh.axis.Regular(10, 0, 1), storage=storage(path))
+    h.fill([0.15, 0.15, 0.55])
+    assert h.values()[1] == 2
+    assert h.values()[5] == 1
+
+    # a copy does not write to the file
+    h2 = h.copy()
+    h2.fill(0.55)
+    assert h.values()[5] == 1
+    assert h2.values()[5] == 2
+
+    del h
+
+    # reopening the file gives back the counts
+    h3 = bh.Histogram(bh.axis.Regular(10, 0, 1), storage=storage(path))
+    assert h3.values()[1] == 2
+    assert h3.values()[5] == 1
+
+    with pytest.raises(ValueError):
+        bh.Histogram(bh.axis.Regular(11, 0, 1), storage=storage(path))
+
+
+@pytest.mark.skipif(env.WIN, reason="File-backed storages require mmap")
+def test_mapped_storage_rejects_growth(tmp_path):
+    with pytest.raises(ValueError):
+        bh.Histogram(
+            bh.axis.Regular(10, 0, 1, growth=True),
+            storage=bh.storage.MappedDouble(str(tmp_path / "hist.bin")),
+        )
+
+
+def _fill_shared(hist, values):
+    hist.fill(values)
+
+
+@pytest.mark.skipif(not env.LINUX, reason="Shared-memory storages are tested on Linux")
+def test_shared_atomic_storage():
+    name = f"bh-test-{uuid.uuid4().hex}"
+    try:
+        h = bh.Histogram(
+            bh.axis.Regular(10, 0, 1), storage=bh.storage.SharedAtomicInt64(name)
+        )
+        h2 = bh.Histogram(
+            bh.axis.Regular(10, 0, 1), storage=bh.storage.SharedAtomicInt64(name)
+        )
+        h.fill(0.55)
+        h2.fill(0.55)
+        assert h[5] == 2
+
+        # unpickling attaches to the same segment
+        h3 = pickle.loads(pickle.dumps(h))
+        h3.fill(0.55)
+        assert h[5] == 3
+
+        ctx = multiprocessing.get_context("fork")
+        with ctx.Pool(2) as pool:
+            pool.starmap(_fill_shared, [(h, [0.15] * 100), (h, [0.15] * 50)])
+        assert h[1] == 150
+    finally:
+        bh.storage.SharedAtomicInt64.unlink(name)
+
+
+@pytest.mark.skipif(not env.LINUX, reason="Shared-memory storages are tested on Linux")
+def test_shared_atomic_storage_unlinked():
+    name = f"bh-test-{uuid.uuid4().hex}"
+    h = bh.Histogram(
+        bh.axis.Regular(10, 0, 1), storage=bh.storage.SharedAtomicInt64(name)
+    )
+    s = pickle.dumps(h)
+    bh.storage.SharedAtomicInt64.unlink(name)
+
+    # the segment is gone, unpickling must not create a fresh one
+    with pytest.raises(RuntimeError):
+        pickle.loads(s)
+    with pytest.raises(RuntimeError):
+        bh.storage.SharedAtomicInt64.unlink(name)
+
+
+@pytest.mark.parametrize("huge_pages", ["none", "transparent", "hugetlb"])
+def test_allocation_policy(huge_pages):
+    old = bh.storage.get_allocation_policy()
+    try:
+        bh.storage.set_allocation_policy(huge_pages=huge_pages, first_touch_threads=4)
+        assert bh.storage.get_allocation_policy() == {
+            "huge_pages": huge_pages,
+            "first_touch_threads": 4,
+        }
+
+        # large enough to be mapped from the OS
+        h = bh.Histogram(bh.axis.Integer(0, 1_000_000), storage=bh.storage.Int64())
+        h.fill([3, 3, 999_999])
+        assert h[3] == 2
+        assert h[999_999] == 1
+        assert h.sum() == 3
+        assert h.view(flow=True).ctypes.data % 64 == 0
+    finally:
+        bh.storage.set_allocation_policy(**old)
+
+
+def test_allocation_policy_invalid():
+    with pytest.raises(ValueError):
+        bh.storage.set_allocation_policy(huge_pages="giant")